@@ -0,0 +1,969 @@
+// Headless benchmarks for the dungeon generator, the quadtree and the player collision checks.
+// No window is opened, so it runs anywhere SFML's graphics module links, e.g. on Linux :
+//   g++ -std=c++14 -O2 -pthread -DLOG_LEVEL=4 -I"../Dungeon Crawler" Benchmark.cpp "../Dungeon Crawler/LevelFile.cpp" -lsfml-graphics -lsfml-window -lsfml-system -o benchmark
+//
+// Every result is printed on its own line as a JSON object so runs can be diffed between versions.
+
+// The generator's warnings are compiled out, they would only measure the console. LOG_LEVEL=4 (errors only) is set
+// for the whole project, LevelFile.cpp included, so every file sees the same inline functions.
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AssetLoader.h"
+#include "Dungeon.h"
+#include "DungeonBatch.h"
+#include "DungeonGraph.h"
+#include "EntityStore.h"
+#include "FloodFill.h"
+#include "FlowField.h"
+#include "ObjectPool.h"
+#include "ChunkedWorld.h"
+#include "Level.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "QuadTree.h"
+#include "TextureAtlas.h"
+#include "TileMapRenderer.h"
+#include "Enemy.h"
+#include "Player.h"
+
+namespace
+{
+	typedef std::chrono::steady_clock BenchClock;
+
+	// every case runs at least this long so short cases are not dominated by clock noise
+	const double minSeconds = 0.5;
+
+	const float blocSize = 40.f;
+
+	// fixed so every run measures the same maps
+	const unsigned int benchSeed = 42;
+
+	// keeps the optimizer from dropping the measured work
+	volatile long long sink = 0;
+
+	// results stream, std::cout itself is muted while benchmarking
+	std::ostream* results = &std::cout;
+
+	class NullBuffer : public std::streambuf
+	{
+	protected:
+		int overflow(int c) override { return c; }
+	};
+
+	double secondsSince(BenchClock::time_point start)
+	{
+		return std::chrono::duration<double>(BenchClock::now() - start).count();
+	}
+
+	void report(const std::string& name, const std::string& params, long long iterations, double value, const std::string& unit)
+	{
+		*results << "{\"benchmark\":\"" << name << "\"," << params
+			<< ",\"iterations\":" << iterations
+			<< ",\"value\":" << value
+			<< ",\"unit\":\"" << unit << "\"}" << std::endl;
+	}
+
+	// same tile to wall conversion as Level, a wall is only its box
+	std::vector<sf::FloatRect> buildWalls(Dungeon::TileView tiles)
+	{
+		std::vector<sf::FloatRect> walls;
+		walls.reserve(tiles.count(Dungeon::Wall));
+
+		for (int y = 0; y < tiles.getHeight(); y++) {
+			for (int x = 0; x < tiles.getWidth(); x++) {
+				if (tiles(x, y) == Dungeon::Wall)
+					walls.push_back(sf::FloatRect(x * blocSize, y * blocSize, blocSize, blocSize));
+			}
+		}
+
+		return walls;
+	}
+
+	void benchGenerate(int width, int height, int maxFeatures)
+	{
+		long long iterations = 0;
+		long long attempts = 0, rejections = 0, prunedExits = 0, stairsDistance = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			Dungeon d(width, height, static_cast<unsigned int>(iterations));
+			d.generate(maxFeatures);
+			sink = sink + d.getTiles()(width / 2, height / 2);
+			attempts += d.getStats().attempts;
+			rejections += d.getStats().rejections;
+			prunedExits += d.getStats().prunedExits;
+			stairsDistance += d.getStats().stairsDistance;
+			++iterations;
+		} while (secondsSince(start) < minSeconds);
+
+		double elapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"features\":" << maxFeatures
+			<< ",\"attempts\":" << attempts / iterations << ",\"rejections\":" << rejections / iterations << ",\"pruned_exits\":" << prunedExits / iterations
+			<< ",\"stairs_distance\":" << stairsDistance / iterations;
+		report("generate", params.str(), iterations, iterations / elapsed, "dungeons/s");
+	}
+
+	double batchSeconds(int width, int height, int maxFeatures, const std::vector<unsigned int>& seeds, unsigned int threadCount, std::vector<Dungeon>& dungeons)
+	{
+		BenchClock::time_point start = BenchClock::now();
+		dungeons = generateDungeons(width, height, maxFeatures, seeds, threadCount);
+		return secondsSince(start);
+	}
+
+	void benchBatch(int width, int height, int maxFeatures, int count)
+	{
+		std::vector<unsigned int> seeds;
+		for (int i = 0; i < count; i++) {
+			seeds.push_back(benchSeed + i);
+		}
+
+		unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<Dungeon> sequential, parallel;
+		double sequentialSeconds = batchSeconds(width, height, maxFeatures, seeds, 1, sequential);
+		double parallelSeconds = batchSeconds(width, height, maxFeatures, seeds, threadCount, parallel);
+
+		// the pool must give the same floors as the sequential run
+		bool identical = true;
+		for (int i = 0; i < count; i++) {
+			identical = identical && sequential[i].getTiles() == parallel[i].getTiles();
+		}
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"features\":" << maxFeatures
+			<< ",\"threads\":" << threadCount << ",\"identical\":" << (identical ? "true" : "false");
+		report("generate_batch_sequential", params.str(), count, count / sequentialSeconds, "dungeons/s");
+		report("generate_batch_parallel", params.str(), count, count / parallelSeconds, "dungeons/s");
+		report("generate_batch_speedup", params.str(), count, sequentialSeconds / parallelSeconds, "x");
+	}
+
+	// counting the walls of a whole map, packed words against the tile by tile loop
+	void benchTileScan(int width, int height)
+	{
+		Dungeon d(width, height, benchSeed);
+		d.generate(1000);
+		Dungeon::TileView tiles = d.getTiles();
+
+		long long iterations = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			sink = sink + tiles.count(Dungeon::Wall);
+			++iterations;
+		} while (secondsSince(start) < minSeconds);
+
+		double packedElapsed = secondsSince(start);
+
+		long long loopIterations = 0;
+		BenchClock::time_point loopStart = BenchClock::now();
+
+		do {
+			int walls = 0;
+			for (char tile : tiles) {
+				walls += tile == Dungeon::Wall;
+			}
+			sink = sink + walls;
+			++loopIterations;
+		} while (secondsSince(loopStart) < minSeconds);
+
+		double loopElapsed = secondsSince(loopStart);
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"tile_bytes\":" << tiles.getGrid().getMemorySize();
+		report("tile_count_packed", params.str(), iterations, packedElapsed * 1e6 / iterations, "us/scan");
+		report("tile_count_iterator", params.str(), loopIterations, loopElapsed * 1e6 / loopIterations, "us/scan");
+	}
+
+	template <typename Pass>
+	void benchFloodPass(const std::string& name, const std::string& params, Pass pass)
+	{
+		long long iterations = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			sink = sink + pass();
+			++iterations;
+		} while (secondsSince(start) < minSeconds);
+
+		report(name, params, iterations, secondsSince(start) * 1e6 / iterations, "us/pass");
+	}
+
+	// connectivity and distance passes over a big finished map, from its center room
+	void benchFloodFill(int width, int height, int maxFeatures)
+	{
+		Dungeon d(width, height, benchSeed);
+		d.generate(maxFeatures);
+		const TileGrid& tiles = d.getTiles().getGrid();
+		Point start = d.getStart();
+
+		FloodFill fill(tiles, Dungeon::walkableCodes());
+		std::vector<uint64_t> targets = fill.makeMask();
+		for (const Rect& room : d.getRooms()) {
+			fill.setBit(targets, room.x + room.width / 2, room.y + room.height / 2);
+		}
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"features\":" << maxFeatures
+			<< ",\"reachable\":" << fill.countReachable(start.x, start.y);
+
+		std::vector<int> distances;
+		benchFloodPass("flood_fill_build", params.str(), [&]() { return FloodFill(tiles, Dungeon::walkableCodes()).getWidth(); });
+		benchFloodPass("flood_fill_reach", params.str(), [&]() { return fill.reach(start.x, start.y)[0]; });
+		benchFloodPass("flood_fill_farthest", params.str(), [&]() { int x, y; return fill.farthest(start.x, start.y, targets, x, y); });
+		benchFloodPass("flood_fill_distances", params.str(), [&]() { fill.distances(start.x, start.y, distances); return distances[0]; });
+	}
+
+	void benchQuadTree(int width, int height, int maxFeatures)
+	{
+		Dungeon d(width, height, benchSeed);
+		d.generate(maxFeatures);
+		std::vector<sf::FloatRect> walls = buildWalls(d.getTiles());
+
+		QuadTree<sf::FloatRect> quadTree(sf::FloatRect(0.f, 0.f, width * blocSize, height * blocSize), 0);
+		for (const sf::FloatRect& wall : walls) {
+			quadTree.insert(wall);
+		}
+
+		// player sized ranges spread over the whole map
+		Random random(benchSeed);
+		std::vector<sf::FloatRect> ranges;
+		for (int i = 0; i < 1024; i++) {
+			ranges.push_back(sf::FloatRect(random.randomInt(width) * blocSize + 10.f, random.randomInt(height) * blocSize + 10.f, 20.f, 20.f));
+		}
+
+		// a new vector per query, then one buffer for all of them like the game loop
+		long long copyIterations = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			for (const sf::FloatRect& range : ranges) {
+				sink = sink + quadTree.getObjects(range).size();
+			}
+			copyIterations += ranges.size();
+		} while (secondsSince(start) < minSeconds);
+
+		double copyElapsed = secondsSince(start);
+
+		std::vector<sf::FloatRect> found;
+		long long iterations = 0;
+		start = BenchClock::now();
+
+		do {
+			for (const sf::FloatRect& range : ranges) {
+				quadTree.getObjects(range, found);
+				sink = sink + found.size();
+			}
+			iterations += ranges.size();
+		} while (secondsSince(start) < minSeconds);
+
+		double elapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"walls\":" << walls.size() << ",\"nodes\":" << quadTree.getNodeCount();
+		report("quadtree_get_objects_copy", params.str(), copyIterations, copyElapsed * 1e9 / copyIterations, "ns/query");
+		report("quadtree_get_objects", params.str(), iterations, elapsed * 1e9 / iterations, "ns/query");
+	}
+
+	// creating then freeing a shape per wall of a big map, one new per shape against a pool, and the boxes the game keeps
+	void benchEntityAllocation(int width, int height, int maxFeatures)
+	{
+		Dungeon d(width, height, benchSeed);
+		d.generate(maxFeatures);
+		Dungeon::TileView tiles = d.getTiles();
+		const int wallCount = tiles.count(Dungeon::Wall);
+
+		long long newPasses = 0;
+		BenchClock::time_point start = BenchClock::now();
+		do {
+			std::vector<sf::RectangleShape*> walls;
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					if (tiles(x, y) == Dungeon::Wall) {
+						walls.push_back(new sf::RectangleShape({ blocSize, blocSize }));
+						walls.back()->setPosition(x * blocSize, y * blocSize);
+					}
+				}
+			}
+			for (sf::RectangleShape* wall : walls) {
+				delete wall;
+			}
+			++newPasses;
+		} while (secondsSince(start) < minSeconds);
+		double newElapsed = secondsSince(start);
+
+		long long poolPasses = 0;
+		start = BenchClock::now();
+		do {
+			ObjectPool<sf::RectangleShape> pool;
+			pool.reserve(wallCount);
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					if (tiles(x, y) == Dungeon::Wall)
+						pool.create(sf::Vector2f(blocSize, blocSize))->setPosition(x * blocSize, y * blocSize);
+				}
+			}
+			sink = sink + pool.size();
+			++poolPasses;
+		} while (secondsSince(start) < minSeconds);
+		double poolElapsed = secondsSince(start);
+
+		long long rectPasses = 0;
+		start = BenchClock::now();
+		do {
+			sink = sink + buildWalls(tiles).size();
+			++rectPasses;
+		} while (secondsSince(start) < minSeconds);
+		double rectElapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"walls\":" << wallCount;
+		report("walls_new_delete", params.str(), newPasses, newElapsed * 1e3 / newPasses, "ms/level");
+		report("walls_object_pool", params.str(), poolPasses, poolElapsed * 1e3 / poolPasses, "ms/level");
+		report("walls_rects", params.str(), rectPasses, rectElapsed * 1e3 / rectPasses, "ms/level");
+	}
+
+	// a whole floor as the game uses it : tiles, entities and quadtree, what the background thread builds
+	void benchLevel()
+	{
+		long long iterations = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			Level level(Level::floorSeed(benchSeed, static_cast<int>(iterations) + 1), blocSize);
+			sink = sink + level.getWalls().size();
+			++iterations;
+		} while (secondsSince(start) < minSeconds);
+
+		double elapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"width\":" << Level::width << ",\"height\":" << Level::height << ",\"features\":" << Level::maxFeatures;
+		report("level_build", params.str(), iterations, iterations / elapsed, "levels/s");
+	}
+
+	// same floor loaded from a level file instead of generated
+	void benchLevelFile()
+	{
+		const std::string path = "benchmark_level.dcl";
+
+		Level generated(benchSeed, blocSize);
+		generated.save(path);
+
+		long long iterations = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			std::unique_ptr<Level> level = Level::load(path, blocSize);
+			sink = sink + level->getWalls().size();
+			++iterations;
+		} while (secondsSince(start) < minSeconds);
+
+		double elapsed = secondsSince(start);
+
+		// the mapped file alone, without building the entities
+		long long opens = 0;
+		BenchClock::time_point openStart = BenchClock::now();
+
+		do {
+			LevelFile file;
+			file.open(path);
+			sink = sink + file.getTile(0, 0);
+			++opens;
+		} while (secondsSince(openStart) < minSeconds);
+
+		double openElapsed = secondsSince(openStart);
+
+		std::unique_ptr<Level> loaded = Level::load(path, blocSize);
+		bool identical = loaded && loaded->getWalls().size() == generated.getWalls().size()
+			&& loaded->getEntities().count(EntityStore::Coin) == generated.getEntities().count(EntityStore::Coin)
+			&& loaded->getEntities().count(EntityStore::Enemy) == generated.getEntities().count(EntityStore::Enemy)
+			&& loaded->getPlayerStart() == generated.getPlayerStart();
+		std::remove(path.c_str());
+
+		std::ostringstream params;
+		params << "\"width\":" << Level::width << ",\"height\":" << Level::height << ",\"identical\":" << (identical ? "true" : "false");
+		report("level_file_load", params.str(), iterations, iterations / elapsed, "levels/s");
+		report("level_file_open", params.str(), opens, openElapsed * 1e6 / opens, "us/open");
+	}
+
+	// enemyCount enemies chasing a player who walks across a big map, what Level::moveEnemies does every frame
+	void benchEnemies(int width, int height, int maxFeatures, int enemyCount, int chaseRadius)
+	{
+		Dungeon d(width, height, benchSeed);
+		d.generate(maxFeatures);
+		Dungeon::TileView tiles = d.getTiles();
+
+		FlowField field(width, height, chaseRadius);
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				field.setWalkable(x, y, (Dungeon::walkableCodes() >> Dungeon::tileCode(tiles(x, y)) & 1) != 0);
+			}
+		}
+
+		// the player walks from the start toward the farthest tile, following its own field
+		Point start = d.getStart();
+		FloodFill fill(tiles.getGrid(), Dungeon::walkableCodes());
+		std::vector<uint64_t> everywhere = fill.reach(start.x, start.y);
+		int goalX = start.x, goalY = start.y;
+		fill.farthest(start.x, start.y, everywhere, goalX, goalY);
+		FlowField path(width, height);
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				path.setWalkable(x, y, field.isWalkable(x, y));
+			}
+		}
+		path.setTarget(goalX, goalY);
+
+		// enemies spread on the tiles around the start
+		field.setTarget(start.x, start.y);
+		Random random(benchSeed);
+		std::vector<sf::Vector2f> enemies;
+		while (static_cast<int>(enemies.size()) < enemyCount) {
+			int x = start.x + random.randomInt(-chaseRadius, chaseRadius);
+			int y = start.y + random.randomInt(-chaseRadius, chaseRadius);
+			if (field.getDistance(x, y) >= 0) {
+				enemies.push_back(sf::Vector2f(x * blocSize, y * blocSize));
+			}
+		}
+
+		const float frameTime = 1.f / 60.f;
+		const float playerSpeed = 150.f, enemySpeed = 60.f;
+		sf::Vector2f player(start.x * blocSize + blocSize / 2, start.y * blocSize + blocSize / 2);
+		long long frames = 0, rebuilds = 0, rebuiltTiles = 0;
+		BenchClock::time_point start2 = BenchClock::now();
+
+		do {
+			int tileX = static_cast<int>(player.x / blocSize), tileY = static_cast<int>(player.y / blocSize);
+			int nextX, nextY;
+			if (path.nextStep(tileX, tileY, nextX, nextY)) {
+				sf::Vector2f delta((nextX - tileX) * playerSpeed * frameTime, (nextY - tileY) * playerSpeed * frameTime);
+				player += delta;
+			}
+
+			if (field.setTarget(static_cast<int>(player.x / blocSize), static_cast<int>(player.y / blocSize))) {
+				++rebuilds;
+				rebuiltTiles += field.getReachedCount();
+			}
+
+			for (sf::Vector2f& enemy : enemies) {
+				enemy = Level::chaseStep(field, enemy, player, blocSize, enemySpeed * frameTime);
+			}
+			sink = sink + static_cast<long long>(enemies[0].x);
+			++frames;
+		} while (secondsSince(start2) < minSeconds);
+
+		double elapsed = secondsSince(start2);
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"enemies\":" << enemyCount << ",\"chase_radius\":" << chaseRadius
+			<< ",\"rebuilds\":" << rebuilds << ",\"tiles_per_rebuild\":" << (rebuilds > 0 ? rebuiltTiles / rebuilds : 0);
+		report("enemies_flow_field", params.str(), frames, elapsed * 1e6 / frames, "us/frame");
+	}
+
+	// plain A* over the tiles, what a path query costs without the room graph
+	int gridPathLength(const FloodFill& fill, Point from, Point to, std::vector<int>& cost, std::vector<int>& touched)
+	{
+		const int width = fill.getWidth();
+		const int offsets[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+		typedef std::pair<int, int> Open; // estimate, tile
+		std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+
+		for (int i : touched) {
+			cost[i] = -1;
+		}
+		touched.clear();
+
+		cost[from.x + from.y * width] = 0;
+		touched.push_back(from.x + from.y * width);
+		open.push(Open(std::abs(from.x - to.x) + std::abs(from.y - to.y), from.x + from.y * width));
+
+		while (!open.empty()) {
+			int i = open.top().second;
+			int x = i % width, y = i / width;
+			open.pop();
+
+			if (x == to.x && y == to.y) {
+				return cost[i];
+			}
+
+			for (const int* offset : offsets) {
+				int nx = x + offset[0], ny = y + offset[1];
+				int n = nx + ny * width;
+				if (fill.isPassable(nx, ny) && (cost[n] < 0 || cost[i] + 1 < cost[n])) {
+					if (cost[n] < 0) {
+						touched.push_back(n);
+					}
+					cost[n] = cost[i] + 1;
+					open.push(Open(cost[n] + std::abs(nx - to.x) + std::abs(ny - to.y), n));
+				}
+			}
+		}
+
+		return -1;
+	}
+
+	// long path queries between random room tiles, through the room graph and with grid A*
+	void benchPathfinding(int width, int height, int maxFeatures, int queryCount)
+	{
+		Dungeon d(width, height, benchSeed);
+		d.generate(maxFeatures);
+		DungeonGraph graph(d);
+		FloodFill fill(d.getTiles().getGrid(), Dungeon::walkableCodes());
+
+		Random random(benchSeed);
+		std::vector<std::pair<Point, Point>> queries;
+		const std::vector<Dungeon::Feature>& features = d.getFeatures();
+		while (static_cast<int>(queries.size()) < queryCount) {
+			Point ends[2];
+			for (Point& end : ends) {
+				const Rect& rect = features[random.randomInt(0, static_cast<int>(features.size()) - 1)].rect;
+				end = Point{ rect.x + random.randomInt(0, rect.width - 1), rect.y + random.randomInt(0, rect.height - 1) };
+			}
+			queries.push_back(std::make_pair(ends[0], ends[1]));
+		}
+
+		std::vector<int> cost(width * height, -1), touched;
+		long long gridSteps = 0, graphSteps = 0;
+		int mismatches = 0;
+
+		BenchClock::time_point start = BenchClock::now();
+		std::vector<int> gridLengths;
+		for (const auto& query : queries) {
+			gridLengths.push_back(gridPathLength(fill, query.first, query.second, cost, touched));
+			gridSteps += gridLengths.back();
+		}
+		double gridElapsed = secondsSince(start);
+
+		long long graphQueries = 0;
+		start = BenchClock::now();
+		do {
+			for (const auto& query : queries) {
+				int length = graph.pathLength(query.first, query.second);
+				if (graphQueries < queryCount) {
+					graphSteps += length;
+					mismatches += length != gridLengths[graphQueries];
+				}
+				++graphQueries;
+			}
+		} while (secondsSince(start) < minSeconds);
+		double graphElapsed = secondsSince(start);
+
+		std::vector<Point> path;
+		long long refineQueries = 0;
+		start = BenchClock::now();
+		do {
+			for (const auto& query : queries) {
+				graph.findPath(query.first, query.second, path);
+				sink = sink + static_cast<long long>(path.size());
+				++refineQueries;
+			}
+		} while (secondsSince(start) < minSeconds);
+		double refineElapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"features\":" << graph.getFeatureCount()
+			<< ",\"doors\":" << graph.getDoorCount() << ",\"mean_length\":" << gridSteps / queryCount << ",\"mismatches\":" << mismatches;
+		report("path_grid_astar", params.str(), queryCount, gridElapsed * 1e6 / queryCount, "us/query");
+		report("path_graph_length", params.str(), graphQueries, graphElapsed * 1e6 / graphQueries, "us/query");
+		report("path_graph_refined", params.str(), refineQueries, refineElapsed * 1e6 / refineQueries, "us/query");
+		sink = sink + graphSteps;
+	}
+
+	// walks a straight line through the infinite world, chunk loading and eviction included
+	void benchChunkedWorld(int distanceInChunks)
+	{
+		const int steps = distanceInChunks * ChunkedWorld::chunkSize * 8;
+		const float step = blocSize / 8.f;
+		int maxLoaded = 0;
+
+		ChunkedWorld world(benchSeed, blocSize);
+		sf::Vector2f position = world.getStartPosition();
+		std::vector<sf::FloatRect> walls;
+		BenchClock::time_point start = BenchClock::now();
+
+		for (int i = 0; i < steps; i++) {
+			position.x += step;
+			position.y += step / 2.f;
+			world.update(position);
+			world.getWalls(sf::FloatRect(position.x, position.y, 20.f, 20.f), walls);
+			sink = sink + walls.size();
+			maxLoaded = std::max(maxLoaded, world.getLoadedChunkCount());
+		}
+
+		double elapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"chunks_walked\":" << distanceInChunks << ",\"max_loaded_chunks\":" << maxLoaded;
+		report("chunked_world_walk", params.str(), steps, elapsed * 1e9 / steps, "ns/frame");
+	}
+
+	// every enemy moves a little then is tested against the player, as Enemy objects and in an EntityStore
+	void benchEntityStore(int count)
+	{
+		Random random(benchSeed);
+		std::vector<sf::Vector2f> positions;
+		for (int i = 0; i < count; i++) {
+			positions.push_back(sf::Vector2f(random.randomInt(1000) * blocSize, random.randomInt(1000) * blocSize));
+		}
+
+		Player player({ 20, 20 }, nullptr);
+		player.setPos(positions[0]);
+		const sf::Vector2f step(0.5f, 0.25f);
+
+		ObjectPool<Enemy> pool;
+		std::vector<Enemy*> objects;
+		for (const sf::Vector2f& position : positions) {
+			objects.push_back(pool.create(sf::Vector2f(blocSize, blocSize), nullptr));
+			objects.back()->setPos(position);
+		}
+
+		long long objectFrames = 0;
+		BenchClock::time_point start = BenchClock::now();
+		do {
+			for (Enemy* enemy : objects) {
+				enemy->move(step);
+				sink = sink + player.getGlobalBounds().intersects(enemy->getGlobalBounds());
+			}
+			++objectFrames;
+		} while (secondsSince(start) < minSeconds);
+		double objectElapsed = secondsSince(start);
+
+		EntityStore store;
+		store.setArea(sf::FloatRect(0.f, 0.f, 1000 * blocSize, 1000 * blocSize));
+		for (const sf::Vector2f& position : positions) {
+			store.create(EntityStore::Enemy, sf::FloatRect(position, sf::Vector2f(blocSize, blocSize)));
+		}
+
+		std::vector<EntityHandle> touched;
+		long long storeFrames = 0;
+		start = BenchClock::now();
+		do {
+			store.forEach(EntityStore::Enemy, [&](EntityHandle enemy) { store.setPosition(enemy, store.getPosition(enemy) + step); });
+			store.findIntersecting(EntityStore::Enemy, player.getGlobalBounds(), touched);
+			sink = sink + touched.size();
+			++storeFrames;
+		} while (secondsSince(start) < minSeconds);
+		double storeElapsed = secondsSince(start);
+
+		std::ostringstream objectParams, storeParams;
+		objectParams << "\"entities\":" << count << ",\"bytes_per_entity\":" << sizeof(Enemy);
+		storeParams << "\"entities\":" << count << ",\"bytes_per_entity\":" << store.getMemorySize() / count;
+		report("entities_objects_update", objectParams.str(), objectFrames, objectElapsed * 1e6 / objectFrames, "us/frame");
+		report("entities_store_update", storeParams.str(), storeFrames, storeElapsed * 1e6 / storeFrames, "us/frame");
+	}
+
+	// the coins the player touches, checking every coin against the quadtree of the store
+	void benchPickups(int count)
+	{
+		Random random(benchSeed);
+		EntityStore store;
+		store.setArea(sf::FloatRect(0.f, 0.f, 1000 * blocSize, 1000 * blocSize));
+		for (int i = 0; i < count; i++) {
+			store.create(EntityStore::Coin, sf::FloatRect(random.randomInt(1000) * blocSize, random.randomInt(1000) * blocSize, blocSize, blocSize));
+		}
+
+		std::vector<sf::FloatRect> ranges;
+		for (int i = 0; i < 1024; i++) {
+			ranges.push_back(sf::FloatRect(random.randomInt(1000) * blocSize + 10.f, random.randomInt(1000) * blocSize + 10.f, 20.f, 20.f));
+		}
+
+		long long scanQueries = 0;
+		BenchClock::time_point start = BenchClock::now();
+		do {
+			for (const sf::FloatRect& range : ranges) {
+				store.forEach(EntityStore::Coin, [&](EntityHandle coin) { sink = sink + store.getBounds(coin).intersects(range); });
+			}
+			scanQueries += ranges.size();
+		} while (secondsSince(start) < minSeconds);
+		double scanElapsed = secondsSince(start);
+
+		std::vector<EntityHandle> touched;
+		long long treeQueries = 0;
+		start = BenchClock::now();
+		do {
+			for (const sf::FloatRect& range : ranges) {
+				store.findIntersecting(EntityStore::Coin, range, touched);
+				sink = sink + touched.size();
+			}
+			treeQueries += ranges.size();
+		} while (secondsSince(start) < minSeconds);
+		double treeElapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"coins\":" << count;
+		report("pickups_scan", params.str(), scanQueries, scanElapsed * 1e9 / scanQueries, "ns/query");
+		report("pickups_quadtree", params.str(), treeQueries, treeElapsed * 1e9 / treeQueries, "ns/query");
+	}
+
+	// vertex arrays of a big floor : the walls once per floor, the coins and enemies in view every frame
+	void benchTileMap(int width, int height, int maxFeatures, int entityCount)
+	{
+		Dungeon d(width, height, benchSeed);
+		d.generate(maxFeatures);
+		std::vector<sf::FloatRect> walls = buildWalls(d.getTiles());
+
+		Random random(benchSeed);
+		EntityStore entities;
+		entities.setArea(sf::FloatRect(0.f, 0.f, width * blocSize, height * blocSize));
+		for (int i = 0; i < entityCount; i++) {
+			sf::FloatRect box(random.randomInt(width) * blocSize, random.randomInt(height) * blocSize, blocSize, blocSize);
+			entities.create(i % 2 == 0 ? EntityStore::Coin : EntityStore::Enemy, box);
+		}
+
+		TextureAtlas atlas;
+		TileMapRenderer tileMap(atlas);
+		const sf::FloatRect stairs(0.f, 0.f, blocSize, blocSize);
+
+		long long builds = 0;
+		BenchClock::time_point start = BenchClock::now();
+		do {
+			tileMap.buildStatic(walls, stairs, blocSize);
+			++builds;
+		} while (secondsSince(start) < minSeconds);
+		double buildElapsed = secondsSince(start);
+
+		// the game's 700x500 view, turned as by one click of the rotation, against the whole map
+		sf::View view(sf::FloatRect(0.f, 0.f, 700.f, 500.f));
+		view.setCenter(width * blocSize / 2.f, height * blocSize / 2.f);
+		view.rotate(45.f);
+		const sf::FloatRect visible = TileMapRenderer::viewBounds(view);
+		const sf::FloatRect everything(0.f, 0.f, width * blocSize, height * blocSize);
+
+		std::ostringstream params;
+		params << "\"width\":" << width << ",\"height\":" << height << ",\"walls\":" << tileMap.getQuadCount(TileMapRenderer::StaticLayer)
+			<< ",\"entities\":" << entityCount;
+		report("tile_map_build_static", params.str(), builds, buildElapsed * 1e3 / builds, "ms/floor");
+
+		// nothing is drawn without a window, the frame is the entity layers and the count of what would be
+		for (bool culled : { false, true }) {
+			const sf::FloatRect area = culled ? visible : everything;
+			long long frames = 0;
+			start = BenchClock::now();
+			do {
+				tileMap.update(entities, area);
+				sink = sink + tileMap.countDrawCalls(area);
+				++frames;
+			} while (secondsSince(start) < minSeconds);
+			double elapsed = secondsSince(start);
+
+			std::ostringstream frameParams;
+			frameParams << params.str() << ",\"culled\":" << (culled ? "true" : "false")
+				<< ",\"draw_calls\":" << tileMap.countDrawCalls(area) << ",\"entities_drawn\":"
+				<< tileMap.getQuadCount(TileMapRenderer::PickupLayer) + tileMap.getQuadCount(TileMapRenderer::ActorLayer);
+			report("tile_map_frame", frameParams.str(), frames, elapsed * 1e6 / frames, "us/frame");
+		}
+	}
+
+	// decoding the game's images and font one after the other, then all at once with AssetLoader
+	void benchAssetLoading(const std::string& directory)
+	{
+		std::vector<std::string> images;
+		for (int i = 0; i < TextureAtlas::FrameCount; i++) {
+			images.push_back(TextureAtlas::getPath(static_cast<TextureAtlas::Frame>(i), directory + "img/"));
+		}
+		const std::vector<std::string> fonts = { directory + "fonts/Minecraft.ttf" };
+
+		long long sequentialPasses = 0;
+		int loaded = 0;
+		BenchClock::time_point start = BenchClock::now();
+		do {
+			loaded = 0;
+			for (const std::string& path : images) {
+				sf::Image image;
+				loaded += image.loadFromFile(path);
+			}
+			for (const std::string& path : fonts) {
+				std::ifstream file(path, std::ios::binary);
+				std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+				loaded += !bytes.empty();
+			}
+			++sequentialPasses;
+		} while (secondsSince(start) < minSeconds);
+		double sequentialElapsed = secondsSince(start);
+
+		long long parallelPasses = 0;
+		start = BenchClock::now();
+		do {
+			AssetLoader loader;
+			loader.start(images, fonts);
+			while (!loader.isDone()) {
+				loader.poll([](AssetLoader::Asset& asset) { sink = sink + asset.loaded; });
+				std::this_thread::yield();
+			}
+			++parallelPasses;
+		} while (secondsSince(start) < minSeconds);
+		double parallelElapsed = secondsSince(start);
+
+		std::ostringstream params;
+		params << "\"files\":" << images.size() + fonts.size() << ",\"loaded\":" << loaded;
+		report("assets_sequential", params.str(), sequentialPasses, sequentialElapsed * 1e3 / sequentialPasses, "ms/load");
+		report("assets_parallel", params.str(), parallelPasses, parallelElapsed * 1e3 / parallelPasses, "ms/load");
+	}
+
+	// what a line of log costs the thread that writes it, a frame's worth of lines at a time :
+	// straight to a file with std::endl like the game used to, then through the logger's ring buffer
+	void benchLogging(int linesPerFrame, int frames)
+	{
+		const std::string path = "benchmark_log.txt";
+		const long long lines = static_cast<long long>(linesPerFrame) * frames;
+
+		double streamElapsed = 0.0;
+		{
+			std::ofstream file(path);
+			for (int frame = 0; frame < frames; frame++) {
+				BenchClock::time_point start = BenchClock::now();
+				for (int i = 0; i < linesPerFrame; i++)
+					file << "possible collision with the wall at " << i * blocSize << ", " << frame * blocSize << std::endl;
+				streamElapsed += secondsSince(start);
+			}
+		}
+
+		double loggerElapsed = 0.0;
+		long long dropped = 0;
+		{
+			std::ofstream file(path);
+			Logger logger(file);
+			for (int frame = 0; frame < frames; frame++) {
+				BenchClock::time_point start = BenchClock::now();
+				for (int i = 0; i < linesPerFrame; i++) {
+					std::ostringstream& line = Logger::stream();
+					line << "possible collision with the wall at " << i * blocSize << ", " << frame * blocSize;
+					logger.write(Logger::Trace, line.str());
+				}
+				loggerElapsed += secondsSince(start);
+
+				// the rest of the frame, the drain thread prints meanwhile
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			dropped = logger.getDroppedCount();
+		}
+		std::remove(path.c_str());
+
+		std::ostringstream params;
+		params << "\"linesPerFrame\":" << linesPerFrame << ",\"dropped\":" << dropped;
+		report("log_stream_endl", params.str(), lines, streamElapsed * 1e9 / lines, "ns/line");
+		report("log_ring_buffer", params.str(), lines, loggerElapsed * 1e9 / lines, "ns/line");
+	}
+
+	// what a timed zone and a counter cost, the trace not recorded like a game run without --profile
+	void benchProfiler()
+	{
+		const int batch = 4096;
+		long long iterations = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			PROFILE_FRAME();
+			for (int i = 0; i < batch; i++) {
+				PROFILE_ZONE("bench");
+				PROFILE_COUNT("bench calls", 1);
+			}
+			iterations += batch;
+		} while (secondsSince(start) < minSeconds);
+
+		double elapsed = secondsSince(start);
+
+		report("profiler_zone", "\"enabled\":" + std::to_string(PROFILER_ENABLED), iterations, elapsed * 1e9 / iterations, "ns/zone");
+	}
+
+	template <typename Test>
+	void benchCollision(const std::string& name, Test test)
+	{
+		const int batch = 4096;
+		long long iterations = 0;
+		BenchClock::time_point start = BenchClock::now();
+
+		do {
+			for (int i = 0; i < batch; i++) {
+				sink = sink + test();
+			}
+			iterations += batch;
+		} while (secondsSince(start) < minSeconds);
+
+		double elapsed = secondsSince(start);
+
+		report(name, "\"objects\":1", iterations, elapsed * 1e9 / iterations, "ns/test");
+	}
+
+	void benchCollisions()
+	{
+		Player player({ 20, 20 }, nullptr);
+		player.setPos({ 50, 50 });
+
+		// half overlapping the player so intersects() does the full computation
+		const sf::FloatRect wall(55.f, 55.f, blocSize, blocSize);
+		const sf::FloatRect stairs(55.f, 55.f, blocSize, blocSize);
+
+		benchCollision("player_colliding_with_wall", [&]() { return player.isCollidingWithWall(wall); });
+		benchCollision("player_colliding_with_stairs", [&]() { return player.isCollidingWithStairs(stairs); });
+	}
+}
+
+int main()
+{
+	const int sizes[][2] = { { 70, 20 }, { 200, 200 }, { 1000, 1000 } };
+	const int features[] = { 15, 100, 1000, 10000 };
+
+	// swallows the "Unable to place ..." messages of Dungeon::generate
+	NullBuffer nullBuffer;
+	std::ostream out(std::cout.rdbuf());
+	results = &out;
+	std::streambuf* coutBuffer = std::cout.rdbuf(&nullBuffer);
+
+	for (const int* size : sizes) {
+		for (int maxFeatures : features) {
+			benchGenerate(size[0], size[1], maxFeatures);
+		}
+	}
+
+	benchBatch(200, 200, 100, 256);
+
+	for (const int* size : sizes) {
+		benchQuadTree(size[0], size[1], 1000);
+	}
+	benchQuadTree(1000, 1000, 10000);
+
+	benchTileScan(1000, 1000);
+
+	benchEntityAllocation(1000, 1000, 10000);
+
+	benchFloodFill(1024, 1024, 10000);
+	benchFloodFill(1024, 1024, 100000);
+
+	benchCollisions();
+	benchEntityStore(10000);
+	benchPickups(10000);
+	benchTileMap(1000, 1000, 10000, 10000);
+
+	benchLevel();
+	benchLevelFile();
+
+	benchEnemies(1000, 1000, 10000, 10000, 64);
+	benchEnemies(1000, 1000, 10000, 10000, 1000);
+
+	benchPathfinding(1000, 1000, 10000, 200);
+
+	benchAssetLoading("../Dungeon Crawler/res/");
+
+	benchLogging(64, 500);
+	benchProfiler();
+
+	benchChunkedWorld(10);
+	benchChunkedWorld(100);
+
+	std::cout.rdbuf(coutBuffer);
+
+	return 0;
+}
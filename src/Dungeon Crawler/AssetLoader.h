@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+// Reads and decodes the asset files on worker threads, one per file, while the main thread goes on.
+// Only the CPU part is done there : images are decoded to pixels and fonts read to memory. Making textures out of them
+// talks to the GPU, so it is left to the main thread, which picks up the finished files with poll() every frame.
+class AssetLoader
+{
+public:
+	struct Asset
+	{
+		std::string path;
+		bool font;
+		bool loaded; // false when the file couldn't be read or decoded
+		double decodeSeconds;
+		sf::Image image; // for an image
+		std::shared_ptr<std::vector<char>> bytes; // for a font, the whole file
+	};
+
+	AssetLoader()
+		: _total(0)
+		, _done(0)
+	{
+	}
+
+	void start(const std::vector<std::string>& images, const std::vector<std::string>& fonts)
+	{
+		for (const std::string& path : images)
+			_pending.push_back(std::async(std::launch::async, decode, path, false));
+		for (const std::string& path : fonts)
+			_pending.push_back(std::async(std::launch::async, decode, path, true));
+
+		_total += static_cast<int>(images.size() + fonts.size());
+	}
+
+	// calls use(asset) for every file decoded since the last call, without waiting for the others
+	template <typename Use>
+	void poll(Use use)
+	{
+		for (auto it = _pending.begin(); it != _pending.end();) {
+			if (it->wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				++it;
+				continue;
+			}
+
+			Asset asset = it->get();
+			it = _pending.erase(it);
+			++_done;
+			use(asset);
+		}
+	}
+
+	int getDoneCount() const
+	{
+		return _done;
+	}
+
+	int getTotalCount() const
+	{
+		return _total;
+	}
+
+	bool isDone() const
+	{
+		return _pending.empty();
+	}
+
+private:
+	static Asset decode(std::string path, bool font)
+	{
+		Asset asset;
+		asset.path = path;
+		asset.font = font;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (font) {
+			std::ifstream file(path, std::ios::binary);
+			asset.bytes = std::make_shared<std::vector<char>>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			asset.loaded = file.is_open() && !asset.bytes->empty();
+		}
+		else {
+			asset.loaded = asset.image.loadFromFile(path);
+		}
+		asset.decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		return asset;
+	}
+
+private:
+	std::vector<std::future<Asset>> _pending;
+	int _total, _done;
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "Dungeon.h"
+#include "QuadTree.h"
+#include "TextureAtlas.h"
+
+// Endless world made of fixed-size dungeons (chunks) generated around the player and dropped once far behind.
+// A chunk only depends on the world seed and its coordinates, so an evicted chunk comes back identical,
+// and the door between two chunks is derived from the edge they share so both sides dig toward the same tile.
+class ChunkedWorld
+{
+public:
+	static const int chunkSize = 32; // tiles per side
+	static const int maxFeatures = 40; // rooms and corridors per chunk
+
+	ChunkedWorld(unsigned int seed, float blocSize, int loadRadius = 1, int keepRadius = 2)
+		: _seed(seed)
+		, _blocSize(blocSize)
+		, _loadRadius(loadRadius)
+		, _keepRadius(keepRadius)
+		, _centerX(0)
+		, _centerY(0)
+		, _start()
+		, _chunks()
+		, _visibleWalls(sf::Quads)
+	{
+		load(0, 0);
+		loadAround(0, 0);
+	}
+
+	// loads the chunks around the position and evicts the ones out of keepRadius, only when the player changes chunk
+	void update(sf::Vector2f position)
+	{
+		int chunkX = chunkOf(position.x);
+		int chunkY = chunkOf(position.y);
+
+		if (chunkX != _centerX || chunkY != _centerY)
+			loadAround(chunkX, chunkY);
+	}
+
+	// boxes of the walls the range overlaps, from the quadtrees of the chunks it overlaps, into walls (cleared first)
+	void getWalls(sf::FloatRect range, std::vector<sf::FloatRect>& walls) const
+	{
+		walls.clear();
+
+		for (int y = chunkOf(range.top); y <= chunkOf(range.top + range.height); ++y)
+			for (int x = chunkOf(range.left); x <= chunkOf(range.left + range.width); ++x) {
+				auto it = _chunks.find(key(x, y));
+				if (it == _chunks.end())
+					continue;
+
+				it->second->quadTree->forEachObject(range, [&walls](const sf::FloatRect& wall) { walls.push_back(wall); });
+			}
+	}
+
+	// only the walls in visible (see TileMapRenderer::viewBounds), found through the quadtrees of the chunks it overlaps.
+	// They are all quads of one vertex array over the atlas, so it is one draw call. Returns the draw calls made.
+	int drawTo(sf::RenderTarget& target, const TextureAtlas& atlas, sf::FloatRect visible)
+	{
+		const sf::IntRect rect = atlas.getRect(TextureAtlas::Wall);
+		const float left = static_cast<float>(rect.left), top = static_cast<float>(rect.top);
+		const float right = left + rect.width, bottom = top + rect.height;
+
+		_visibleWalls.clear();
+		for (int y = chunkOf(visible.top); y <= chunkOf(visible.top + visible.height); ++y)
+			for (int x = chunkOf(visible.left); x <= chunkOf(visible.left + visible.width); ++x) {
+				auto it = _chunks.find(key(x, y));
+				if (it == _chunks.end())
+					continue;
+
+				it->second->quadTree->forEachObject(visible, [&](const sf::FloatRect& box) {
+					_visibleWalls.append(sf::Vertex(sf::Vector2f(box.left, box.top), sf::Vector2f(left, top)));
+					_visibleWalls.append(sf::Vertex(sf::Vector2f(box.left + box.width, box.top), sf::Vector2f(right, top)));
+					_visibleWalls.append(sf::Vertex(sf::Vector2f(box.left + box.width, box.top + box.height), sf::Vector2f(right, bottom)));
+					_visibleWalls.append(sf::Vertex(sf::Vector2f(box.left, box.top + box.height), sf::Vector2f(left, bottom)));
+				});
+			}
+
+		if (_visibleWalls.getVertexCount() == 0)
+			return 0;
+
+		target.draw(_visibleWalls, sf::RenderStates(&atlas.getTexture()));
+		return 1;
+	}
+
+	// walls drawn by the last drawTo
+	int getVisibleWallCount() const
+	{
+		return static_cast<int>(_visibleWalls.getVertexCount() / 4);
+	}
+
+	// center of the first room of chunk (0, 0)
+	sf::Vector2f getStartPosition() const
+	{
+		return { _start.x * _blocSize, _start.y * _blocSize };
+	}
+
+	int getLoadedChunkCount() const
+	{
+		return static_cast<int>(_chunks.size());
+	}
+
+private:
+	struct Chunk
+	{
+		int x, y;
+		std::unique_ptr<QuadTree<sf::FloatRect>> quadTree; // the box of every wall, nothing else keeps them
+	};
+
+	// both coordinates as 32 unsigned bits, a negative one is never shifted
+	static unsigned long long key(int x, int y)
+	{
+		return (static_cast<unsigned long long>(static_cast<unsigned int>(x)) << 32) | static_cast<unsigned int>(y);
+	}
+
+	// mixes the world seed with up to 3 coordinates (splitmix64 finalizer)
+	static unsigned int hash(unsigned int seed, int a, int b, int c)
+	{
+		uint64_t h = seed;
+		for (int v : { a, b, c }) {
+			h += 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(v);
+			h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+			h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+			h ^= h >> 31;
+		}
+		return static_cast<unsigned int>(h);
+	}
+
+	int chunkOf(float pixel) const
+	{
+		return static_cast<int>(std::floor(pixel / (_blocSize * chunkSize)));
+	}
+
+	// position of the door on the edge shared by two chunks, away from the corners
+	int doorOffset(int x, int y, int vertical) const
+	{
+		return 2 + hash(_seed, x, y, vertical) % (chunkSize - 4);
+	}
+
+	void loadAround(int chunkX, int chunkY)
+	{
+		_centerX = chunkX;
+		_centerY = chunkY;
+
+		for (auto it = _chunks.begin(); it != _chunks.end();) {
+			if (std::abs(it->second->x - chunkX) > _keepRadius || std::abs(it->second->y - chunkY) > _keepRadius)
+				it = _chunks.erase(it);
+			else
+				++it;
+		}
+
+		for (int y = chunkY - _loadRadius; y <= chunkY + _loadRadius; ++y)
+			for (int x = chunkX - _loadRadius; x <= chunkX + _loadRadius; ++x)
+				load(x, y);
+	}
+
+	void load(int x, int y)
+	{
+		if (_chunks.count(key(x, y)) != 0)
+			return;
+
+		// west, east, north and south edges, keyed by the chunk on their west/north side
+		std::vector<Point> entrances;
+		entrances.push_back(Point{ 0, doorOffset(x - 1, y, 1) });
+		entrances.push_back(Point{ chunkSize - 1, doorOffset(x, y, 1) });
+		entrances.push_back(Point{ doorOffset(x, y - 1, 0), 0 });
+		entrances.push_back(Point{ doorOffset(x, y, 0), chunkSize - 1 });
+
+		Dungeon d(chunkSize, chunkSize, hash(_seed, x, y, 2));
+		d.generate(maxFeatures, entrances);
+
+		if (x == 0 && y == 0)
+			_start = d.getStart();
+
+		std::unique_ptr<Chunk> chunk(new Chunk());
+		chunk->x = x;
+		chunk->y = y;
+
+		float left = x * chunkSize * _blocSize;
+		float top = y * chunkSize * _blocSize;
+		chunk->quadTree.reset(new QuadTree<sf::FloatRect>(sf::FloatRect(left, top, chunkSize * _blocSize, chunkSize * _blocSize), 0));
+
+		Dungeon::TileView tiles = d.getTiles();
+		for (int ty = 0; ty < chunkSize; ty++) {
+			for (int tx = 0; tx < chunkSize; tx++) {
+				if (tiles(tx, ty) == Dungeon::Wall)
+					chunk->quadTree->insert(sf::FloatRect(left + tx * _blocSize, top + ty * _blocSize, _blocSize, _blocSize));
+			}
+		}
+
+		_chunks[key(x, y)] = std::move(chunk);
+	}
+
+private:
+	unsigned int _seed;
+	float _blocSize;
+	int _loadRadius, _keepRadius;
+	int _centerX, _centerY;
+	Point _start;
+	std::unordered_map<unsigned long long, std::unique_ptr<Chunk>> _chunks;
+	sf::VertexArray _visibleWalls; // refilled by every drawTo
+};
@@ -0,0 +1,827 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include <iostream>
+#include "FloodFill.h"
+#include "Logger.h"
+#include "Random.h"
+#include "TileGrid.h"
+
+struct Rect
+{
+	int x, y;
+	int width, height;
+};
+
+struct Point
+{
+	int x, y;
+};
+
+class Dungeon
+{
+public:
+	enum Tile
+	{
+		Unused = ' ',
+		Floor = '.',
+		Corridor = ',',
+		Wall = '#',
+		ClosedDoor = '+',
+		OpenDoor = '-',
+		UpStairs = '<',
+		DownStairs = '>',
+		Coin = '*',
+		Enemy = '/'
+	};
+
+	enum Direction
+	{
+		North,
+		South,
+		West,
+		East,
+		DirectionCount
+	};
+
+	// counters of the last generate(), to see where the attempts of createFeature go
+	struct GenerationStats
+	{
+		int features = 0; // rooms and corridors placed, the first room included
+		int attempts = 0; // exits sampled by createFeature
+		int rejections = 0; // sampled exits where no room or corridor fitted
+		int prunedExits = 0; // exits dropped because none of their cells can grow anymore
+		int stairsDistance = -1; // steps between the up and down stairs
+	};
+
+	// a room or a corridor, kept even once the stairs took its room
+	struct Feature
+	{
+		Rect rect;
+		bool room;
+	};
+
+	// tile through which a feature was grown from another one, from and to are indices in getFeatures()
+	struct Door
+	{
+		Point position;
+		int from, to;
+	};
+
+	// Read-only view of the packed tiles, gives the same chars as the old std::vector<char> without copying the map.
+	// It points into the dungeon, so it must not outlive it.
+	class TileView
+	{
+	public:
+		class const_iterator
+		{
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef char value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const char* pointer;
+			typedef char reference;
+
+			const_iterator(const TileGrid* grid, int x, int y)
+				: _grid(grid)
+				, _x(x)
+				, _y(y)
+			{
+			}
+
+			char operator*() const
+			{
+				return tileFromCode(_grid->get(_x, _y));
+			}
+
+			const_iterator& operator++()
+			{
+				if (++_x == _grid->getWidth())
+				{
+					_x = 0;
+					++_y;
+				}
+
+				return *this;
+			}
+
+			const_iterator operator++(int)
+			{
+				const_iterator previous = *this;
+				++*this;
+				return previous;
+			}
+
+			bool operator==(const const_iterator& other) const
+			{
+				return _x == other._x && _y == other._y;
+			}
+
+			bool operator!=(const const_iterator& other) const
+			{
+				return !(*this == other);
+			}
+
+		private:
+			const TileGrid* _grid;
+			int _x, _y;
+		};
+
+		explicit TileView(const TileGrid& grid)
+			: _grid(&grid)
+		{
+		}
+
+		char operator()(int x, int y) const
+		{
+			return tileFromCode(_grid->get(x, y));
+		}
+
+		// same indexing as the old vector, x + y * width
+		char operator[](int i) const
+		{
+			return tileFromCode(_grid->get(i % _grid->getWidth(), i / _grid->getWidth()));
+		}
+
+		int size() const
+		{
+			return _grid->getWidth() * _grid->getHeight();
+		}
+
+		int getWidth() const
+		{
+			return _grid->getWidth();
+		}
+
+		int getHeight() const
+		{
+			return _grid->getHeight();
+		}
+
+		// whole map scan, 16 tiles per step
+		int count(char tile) const
+		{
+			return _grid->count(tileCode(tile));
+		}
+
+		const TileGrid& getGrid() const
+		{
+			return *_grid;
+		}
+
+		const_iterator begin() const
+		{
+			return const_iterator(_grid, 0, _grid->getWidth() > 0 ? 0 : _grid->getHeight());
+		}
+
+		const_iterator end() const
+		{
+			return const_iterator(_grid, 0, _grid->getHeight());
+		}
+
+		bool operator==(const TileView& other) const
+		{
+			return *_grid == *other._grid;
+		}
+
+		bool operator!=(const TileView& other) const
+		{
+			return !(*this == other);
+		}
+
+	private:
+		const TileGrid* _grid;
+	};
+
+public:
+	Dungeon(int width, int height, unsigned int seed)
+		: _width(width)
+		, _height(height)
+		, _tiles(width, height, tileCode(Unused))
+		, _rowWords((width + 63) / 64)
+		, _used(_rowWords* height, 0)
+		, _rooms()
+		, _exits()
+		, _exitOwners()
+		, _features()
+		, _doors()
+		, _random(seed)
+		, _stats()
+		, _start()
+	{
+	}
+
+	void generate(int maxFeatures)
+	{
+		generate(maxFeatures, std::vector<Point>());
+	}
+
+	// entrances are border tiles that get a corridor dug to the rest of the dungeon before the stairs are placed
+	void generate(int maxFeatures, const std::vector<Point>& entrances)
+	{
+		// place the first room in the center
+		if (!makeRoom(_width / 2, _height / 2, static_cast<Direction>(_random.randomInt(4), true)))
+		{
+			LOG_WARNING("Unable to place the first room.");
+			return;
+		}
+
+		_start = Point{ _rooms[0].x + _rooms[0].width / 2, _rooms[0].y + _rooms[0].height / 2 };
+		_stats.features = 1;
+
+		// we already placed 1 feature (the first room)
+		for (int i = 1; i < maxFeatures; ++i)
+		{
+			if (!createFeature())
+			{
+				LOG_WARNING("Unable to place more features (placed " << i << ").");
+				break;
+			}
+		}
+
+		for (const Point& entrance : entrances)
+			digCorridor(entrance, _start);
+
+		Point upStairs;
+		if (!placeObject(UpStairs, upStairs))
+		{
+			LOG_WARNING("Unable to place up stairs.");
+			return;
+		}
+
+		// a layout where no room can be reached from the up stairs is rejected here
+		if (!placeFarthest(DownStairs, upStairs))
+		{
+			LOG_WARNING("Unable to place down stairs.");
+			return;
+		}
+
+		// Unused becomes '.' and Floor or Corridor become ' ', rewritten 16 tiles at a time
+		for (int y = 0; y < _height; ++y)
+		{
+			uint64_t* row = _tiles.row(y);
+
+			for (int w = 0; w < _tiles.getRowWords(); ++w)
+			{
+				uint64_t unused = TileGrid::lanesEqual(row[w], tileCode(Unused)) & _tiles.validMask(w);
+				uint64_t open = TileGrid::lanesEqual(row[w], tileCode(Floor)) | TileGrid::lanesEqual(row[w], tileCode(Corridor));
+
+				row[w] = (row[w] & ~(open * 15)) | unused * tileCode('.');
+			}
+		}
+	}
+
+	void print()
+	{
+		for (int y = 0; y < _height; ++y)
+		{
+			for (int x = 0; x < _width; ++x)
+				std::cout << getTile(x, y);
+
+			std::cout << std::endl;
+		}
+	}
+
+	TileView getTiles() const
+	{
+		return TileView(_tiles);
+	}
+
+	unsigned int getSeed() const
+	{
+		return _random.getSeed();
+	}
+
+	const GenerationStats& getStats() const
+	{
+		return _stats;
+	}
+
+	// center of the first room, every feature is connected to it
+	Point getStart() const
+	{
+		return _start;
+	}
+
+	int getWidth() const
+	{
+		return _width;
+	}
+
+	int getHeight() const
+	{
+		return _height;
+	}
+
+	// rooms left after the stairs took theirs
+	const std::vector<Rect>& getRooms() const
+	{
+		return _rooms;
+	}
+
+	// sides that were never used to grow a feature
+	const std::vector<Rect>& getExits() const
+	{
+		return _exits;
+	}
+
+	// every room and corridor in the order they were placed, the first room first
+	const std::vector<Feature>& getFeatures() const
+	{
+		return _features;
+	}
+
+	// how the features connect, one door per feature but the first room
+	// (the corridors dug toward the entrances aren't part of it)
+	const std::vector<Door>& getDoors() const
+	{
+		return _doors;
+	}
+
+	// tile codes a character can walk on in the finished map (what getTiles() gives), for FloodFill
+	static unsigned int walkableCodes()
+	{
+		return 1u << tileCode(' ') | 1u << tileCode(ClosedDoor) | 1u << tileCode(OpenDoor) | 1u << tileCode(UpStairs)
+			| 1u << tileCode(DownStairs) | 1u << tileCode(Coin) | 1u << tileCode(Enemy);
+	}
+
+	// 4 bit code of a tile, there are only 10 tile values so two tiles fit in a byte
+	static int tileCode(char tile)
+	{
+		switch (tile)
+		{
+		case Floor: return 1;
+		case Corridor: return 2;
+		case Wall: return 3;
+		case ClosedDoor: return 4;
+		case OpenDoor: return 5;
+		case UpStairs: return 6;
+		case DownStairs: return 7;
+		case Coin: return 8;
+		case Enemy: return 9;
+		default: return 0; // Unused
+		}
+	}
+
+	static char tileFromCode(int code)
+	{
+		static const char tiles[16] = { Unused, Floor, Corridor, Wall, ClosedDoor, OpenDoor, UpStairs, DownStairs, Coin, Enemy,
+			Unused, Unused, Unused, Unused, Unused, Unused };
+
+		return tiles[code & 15];
+	}
+
+private:
+	char getTile(int x, int y) const
+	{
+		if (x < 0 || y < 0 || x >= _width || y >= _height)
+			return Unused;
+
+		return tileFromCode(_tiles.get(x, y));
+	}
+
+	void setTile(int x, int y, char tile)
+	{
+		_tiles.set(x, y, tileCode(tile));
+
+		// keep the occupancy bits in sync with the tiles
+		uint64_t bit = uint64_t(1) << (x & 63);
+		if (tile != Unused)
+			_used[(x >> 6) + y * _rowWords] |= bit;
+		else
+			_used[(x >> 6) + y * _rowWords] &= ~bit;
+	}
+
+	// same as checking getTile(x, y) == Unused on every cell, but one word test per row (two when the rect crosses a word)
+	bool isUnused(const Rect& rect) const
+	{
+		for (int y = rect.y; y < rect.y + rect.height; ++y)
+		{
+			const uint64_t* row = &_used[y * _rowWords];
+
+			for (int x = rect.x; x < rect.x + rect.width;)
+			{
+				int first = x & 63;
+				int count = std::min(64 - first, rect.x + rect.width - x);
+				uint64_t mask = (count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1) << first;
+
+				if (row[x >> 6] & mask)
+					return false;
+
+				x += count;
+			}
+		}
+
+		return true;
+	}
+
+	bool createFeature()
+	{
+		for (int i = 0; i < 1000; ++i)
+		{
+			if (_exits.empty())
+				break;
+
+			// choose a random side of a random room or corridor
+			int r = _random.randomInt(_exits.size());
+
+			// a side that is blocked everywhere will never grow, drop it without spending the attempt
+			if (!canGrow(_exits[r]))
+			{
+				removeAt(_exits, r);
+				removeAt(_exitOwners, r);
+				++_stats.prunedExits;
+				--i;
+				continue;
+			}
+
+			int x = _random.randomInt(_exits[r].x, _exits[r].x + _exits[r].width - 1);
+			int y = _random.randomInt(_exits[r].y, _exits[r].y + _exits[r].height - 1);
+
+			++_stats.attempts;
+
+			// north, south, west, east
+			for (int j = 0; j < DirectionCount; ++j)
+			{
+				if (createFeature(x, y, static_cast<Direction>(j)))
+				{
+					_doors.push_back(Door{ Point{ x, y }, _exitOwners[r], static_cast<int>(_features.size()) - 1 });
+					removeAt(_exits, r);
+					removeAt(_exitOwners, r);
+					++_stats.features;
+					return true;
+				}
+			}
+
+			++_stats.rejections;
+		}
+
+		return false;
+	}
+
+	// A room or corridor grown from (x, y) always covers the cell opposite to the floor it grows from,
+	// so an exit can only grow if one of its cells has floor on one side and an unused cell on the other.
+	bool canGrow(const Rect& exit) const
+	{
+		static const int offsets[DirectionCount][2] = { { 0, 1 }, { 0, -1 }, { 1, 0 }, { -1, 0 } };
+
+		for (int y = exit.y; y < exit.y + exit.height; ++y)
+			for (int x = exit.x; x < exit.x + exit.width; ++x)
+				for (const int* offset : offsets)
+				{
+					char from = getTile(x + offset[0], y + offset[1]);
+					int toX = x - offset[0];
+					int toY = y - offset[1];
+
+					if ((from == Floor || from == Corridor)
+						&& toX >= 1 && toY >= 1 && toX < _width - 1 && toY < _height - 1
+						&& getTile(toX, toY) == Unused)
+						return true;
+				}
+
+		return false;
+	}
+
+	// O(1) removal, the order of the candidates doesn't matter since they are sampled at random
+	template <typename T>
+	static void removeAt(std::vector<T>& items, int i)
+	{
+		items[i] = items.back();
+		items.pop_back();
+	}
+
+	// the sides of a feature are only added right after it is placed, so they belong to the last one
+	void addExit(const Rect& exit)
+	{
+		_exits.push_back(exit);
+		_exitOwners.push_back(static_cast<int>(_features.size()) - 1);
+	}
+
+	bool createFeature(int x, int y, Direction dir)
+	{
+		static const int roomChance = 50; // corridorChance = 100 - roomChance
+
+		int dx = 0;
+		int dy = 0;
+
+		if (dir == North)
+			dy = 1;
+		else if (dir == South)
+			dy = -1;
+		else if (dir == West)
+			dx = 1;
+		else if (dir == East)
+			dx = -1;
+
+		if (getTile(x + dx, y + dy) != Floor && getTile(x + dx, y + dy) != Corridor)
+			return false;
+
+		if (_random.randomInt(100) < roomChance)
+		{
+			if (makeRoom(x, y, dir))
+			{
+				setTile(x, y, ClosedDoor);
+
+				return true;
+			}
+		}
+
+		else
+		{
+			if (makeCorridor(x, y, dir))
+			{
+				if (getTile(x + dx, y + dy) == Floor)
+					setTile(x, y, ClosedDoor);
+				else // don't place a door between corridors
+					setTile(x, y, Corridor);
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool makeRoom(int x, int y, Direction dir, bool firstRoom = false)
+	{
+		static const int minRoomSize = 3;
+		static const int maxRoomSize = 6;
+
+		Rect room;
+		room.width = _random.randomInt(minRoomSize, maxRoomSize);
+		room.height = _random.randomInt(minRoomSize, maxRoomSize);
+
+		if (dir == North)
+		{
+			room.x = x - room.width / 2;
+			room.y = y - room.height;
+		}
+
+		else if (dir == South)
+		{
+			room.x = x - room.width / 2;
+			room.y = y + 1;
+		}
+
+		else if (dir == West)
+		{
+			room.x = x - room.width;
+			room.y = y - room.height / 2;
+		}
+
+		else if (dir == East)
+		{
+			room.x = x + 1;
+			room.y = y - room.height / 2;
+		}
+
+		if (placeRect(room, Floor))
+		{
+			_rooms.emplace_back(room);
+			_features.push_back(Feature{ room, true });
+
+			if (dir != South || firstRoom) // north side
+				addExit(Rect{ room.x, room.y - 1, room.width, 1 });
+			if (dir != North || firstRoom) // south side
+				addExit(Rect{ room.x, room.y + room.height, room.width, 1 });
+			if (dir != East || firstRoom) // west side
+				addExit(Rect{ room.x - 1, room.y, 1, room.height });
+			if (dir != West || firstRoom) // east side
+				addExit(Rect{ room.x + room.width, room.y, 1, room.height });
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool makeCorridor(int x, int y, Direction dir)
+	{
+		static const int minCorridorLength = 3;
+		static const int maxCorridorLength = 6;
+
+		Rect corridor;
+		corridor.x = x;
+		corridor.y = y;
+
+		if (_random.randomBool()) // horizontal corridor
+		{
+			corridor.width = _random.randomInt(minCorridorLength, maxCorridorLength);
+			corridor.height = 1;
+
+			if (dir == North)
+			{
+				corridor.y = y - 1;
+
+				if (_random.randomBool()) // west
+					corridor.x = x - corridor.width + 1;
+			}
+
+			else if (dir == South)
+			{
+				corridor.y = y + 1;
+
+				if (_random.randomBool()) // west
+					corridor.x = x - corridor.width + 1;
+			}
+
+			else if (dir == West)
+				corridor.x = x - corridor.width;
+
+			else if (dir == East)
+				corridor.x = x + 1;
+		}
+
+		else // vertical corridor
+		{
+			corridor.width = 1;
+			corridor.height = _random.randomInt(minCorridorLength, maxCorridorLength);
+
+			if (dir == North)
+				corridor.y = y - corridor.height;
+
+			else if (dir == South)
+				corridor.y = y + 1;
+
+			else if (dir == West)
+			{
+				corridor.x = x - 1;
+
+				if (_random.randomBool()) // north
+					corridor.y = y - corridor.height + 1;
+			}
+
+			else if (dir == East)
+			{
+				corridor.x = x + 1;
+
+				if (_random.randomBool()) // north
+					corridor.y = y - corridor.height + 1;
+			}
+		}
+
+		if (placeRect(corridor, Corridor))
+		{
+			_features.push_back(Feature{ corridor, false });
+
+			if (dir != South && corridor.width != 1) // north side
+				addExit(Rect{ corridor.x, corridor.y - 1, corridor.width, 1 });
+			if (dir != North && corridor.width != 1) // south side
+				addExit(Rect{ corridor.x, corridor.y + corridor.height, corridor.width, 1 });
+			if (dir != East && corridor.height != 1) // west side
+				addExit(Rect{ corridor.x - 1, corridor.y, 1, corridor.height });
+			if (dir != West && corridor.height != 1) // east side
+				addExit(Rect{ corridor.x + corridor.width, corridor.y, 1, corridor.height });
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool placeRect(const Rect& rect, char tile)
+	{
+		if (rect.x < 1 || rect.y < 1 || rect.x + rect.width > _width - 1 || rect.y + rect.height > _height - 1)
+			return false;
+
+		if (!isUnused(rect))
+			return false; // the area already used
+
+		for (int y = rect.y - 1; y < rect.y + rect.height + 1; ++y)
+			for (int x = rect.x - 1; x < rect.x + rect.width + 1; ++x)
+			{
+				if (x == rect.x - 1 || y == rect.y - 1 || x == rect.x + rect.width || y == rect.y + rect.height)
+					setTile(x, y, Wall);
+				else
+					setTile(x, y, tile);
+			}
+
+		return true;
+	}
+
+	// Digs an L-shaped corridor from a border tile toward "to", along the axis leaving the border first,
+	// and stops as soon as it reaches floor since everything placed by generate() is already connected.
+	void digCorridor(Point from, Point to)
+	{
+		bool horizontalFirst = from.x == 0 || from.x == _width - 1;
+		int x = from.x;
+		int y = from.y;
+
+		while (getTile(x, y) != Floor && getTile(x, y) != Corridor)
+		{
+			setTile(x, y, Corridor);
+
+			// wall in the corridor where it runs through unused space
+			for (int wy = y - 1; wy <= y + 1; ++wy)
+				for (int wx = x - 1; wx <= x + 1; ++wx)
+					if (wx >= 0 && wy >= 0 && wx < _width && wy < _height && getTile(wx, wy) == Unused)
+						setTile(wx, wy, Wall);
+
+			if (x == to.x && y == to.y)
+				break;
+
+			if (horizontalFirst ? x != to.x : y == to.y)
+				x += x < to.x ? 1 : -1;
+			else
+				y += y < to.y ? 1 : -1;
+		}
+	}
+
+	bool placeObject(char tile, Point& position)
+	{
+		if (_rooms.empty())
+			return false;
+
+		int r = _random.randomInt(_rooms.size()); // choose a random room
+		int x = _random.randomInt(_rooms[r].x + 1, _rooms[r].x + _rooms[r].width - 2);
+		int y = _random.randomInt(_rooms[r].y + 1, _rooms[r].y + _rooms[r].height - 2);
+
+		if (getTile(x, y) == Floor)
+		{
+			setTile(x, y, tile);
+			position = Point{ x, y };
+
+			// place one object in one room (optional)
+			removeAt(_rooms, r);
+
+			return true;
+		}
+
+		return false;
+	}
+
+	// smallest rect holding every tile that isn't Unused, to the word for the columns
+	Rect usedArea() const
+	{
+		int top = _height, bottom = -1, left = _rowWords, right = -1;
+
+		for (int y = 0; y < _height; ++y)
+			for (int w = 0; w < _rowWords; ++w)
+				if (_used[w + y * _rowWords] != 0)
+				{
+					top = std::min(top, y);
+					bottom = y;
+					left = std::min(left, w);
+					right = std::max(right, w);
+				}
+
+		if (bottom < 0)
+			return Rect{ 0, 0, 0, 0 };
+
+		return Rect{ left * 64, top, std::min(_width, (right + 1) * 64) - left * 64, bottom - top + 1 };
+	}
+
+	// Puts the tile in the room the farthest in steps from "from", on the same cells placeObject() picks from,
+	// so the stairs end up as far apart as the layout allows. Fails when no room can be reached.
+	bool placeFarthest(char tile, Point from)
+	{
+		// the map isn't remapped yet, floor and corridors are still Floor and Corridor
+		unsigned int walkable = 1u << tileCode(Floor) | 1u << tileCode(Corridor) | 1u << tileCode(ClosedDoor)
+			| 1u << tileCode(OpenDoor) | 1u << tileCode(UpStairs) | 1u << tileCode(DownStairs);
+
+		// only the part of the map the features cover is looked at
+		Rect area = usedArea();
+		FloodFill fill(_tiles, walkable, area.x, area.y, area.width, area.height);
+		std::vector<uint64_t> targets = fill.makeMask();
+
+		for (const Rect& room : _rooms)
+			for (int y = room.y + 1; y <= room.y + room.height - 2; ++y)
+				for (int x = room.x + 1; x <= room.x + room.width - 2; ++x)
+					if (getTile(x, y) == Floor)
+						fill.setBit(targets, x, y);
+
+		int x, y;
+		_stats.stairsDistance = fill.farthest(from.x, from.y, targets, x, y);
+		if (_stats.stairsDistance < 0)
+			return false;
+
+		setTile(x, y, tile);
+
+		for (int r = 0; r < static_cast<int>(_rooms.size()); ++r)
+			if (x >= _rooms[r].x && y >= _rooms[r].y && x < _rooms[r].x + _rooms[r].width && y < _rooms[r].y + _rooms[r].height)
+			{
+				removeAt(_rooms, r);
+				break;
+			}
+
+		return true;
+	}
+
+private:
+	int _width, _height;
+	TileGrid _tiles; // Tile values as tileCode(), 4 bits each
+	int _rowWords;
+	std::vector<uint64_t> _used; // one bit per tile set when the tile isn't Unused, rows padded to whole words
+	std::vector<Rect> _rooms; // rooms for place stairs or monsters
+	std::vector<Rect> _exits; // 4 sides of rooms or corridors
+	std::vector<int> _exitOwners; // feature of every exit
+	std::vector<Feature> _features;
+	std::vector<Door> _doors;
+	Random _random;
+	GenerationStats _stats;
+	Point _start;
+};
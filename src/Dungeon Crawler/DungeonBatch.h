@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Dungeon.h"
+
+// Generates one dungeon per seed on a pool of worker threads (one per core by default).
+// dungeons[i] is identical to Dungeon(width, height, seeds[i]) generated on its own, whatever the thread count.
+inline std::vector<Dungeon> generateDungeons(int width, int height, int maxFeatures, const std::vector<unsigned int>& seeds, unsigned int threadCount = 0)
+{
+	std::vector<Dungeon> dungeons;
+	dungeons.reserve(seeds.size());
+
+	for (unsigned int seed : seeds)
+		dungeons.emplace_back(width, height, seed);
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	threadCount = std::min<unsigned int>(threadCount, static_cast<unsigned int>(dungeons.size()));
+
+	// every dungeon owns its engine and its tiles, the workers only share the next index
+	std::atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < dungeons.size(); i = next++)
+			dungeons[i].generate(maxFeatures);
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threadCount; ++i)
+		workers.emplace_back(worker);
+
+	// the calling thread works too
+	worker();
+
+	for (std::thread& t : workers)
+		t.join();
+
+	return dungeons;
+}
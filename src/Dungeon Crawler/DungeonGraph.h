@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <vector>
+#include "Dungeon.h"
+
+// Rooms and corridors of a dungeon with the doors between them, for paths across big maps.
+// Every feature is an empty rectangle, so inside one the shortest path between two cells is their manhattan distance.
+// A query is a hierarchical search : A* over the doors only, each feature crossed costing that distance,
+// then the path is refined inside every feature crossed with straight lines, without looking at a single tile.
+class DungeonGraph
+{
+public:
+	typedef Dungeon::Feature Feature;
+	typedef Dungeon::Door Door;
+
+	explicit DungeonGraph(const Dungeon& dungeon)
+		: _width(dungeon.getWidth())
+		, _height(dungeon.getHeight())
+		, _features(dungeon.getFeatures())
+		, _doors(dungeon.getDoors())
+		, _featureDoors(dungeon.getFeatures().size())
+		, _at(dungeon.getWidth()* dungeon.getHeight(), -1)
+	{
+		for (int f = 0; f < static_cast<int>(_features.size()); ++f)
+		{
+			const Rect& rect = _features[f].rect;
+			for (int y = rect.y; y < rect.y + rect.height; ++y)
+				for (int x = rect.x; x < rect.x + rect.width; ++x)
+					_at[x + y * _width] = f;
+		}
+
+		for (int d = 0; d < static_cast<int>(_doors.size()); ++d)
+		{
+			_featureDoors[_doors[d].from].push_back(d);
+			_featureDoors[_doors[d].to].push_back(d);
+			_at[_doors[d].position.x + _doors[d].position.y * _width] = doorMark(d);
+		}
+	}
+
+	int getFeatureCount() const
+	{
+		return static_cast<int>(_features.size());
+	}
+
+	int getDoorCount() const
+	{
+		return static_cast<int>(_doors.size());
+	}
+
+	// feature covering the tile, -1 for a door or a tile outside of every feature
+	int getFeatureAt(int x, int y) const
+	{
+		int at = inside(x, y) ? _at[x + y * _width] : -1;
+		return at >= 0 ? at : -1;
+	}
+
+	// length in steps of the path between two tiles of features or doors, -1 if there is none
+	int pathLength(Point from, Point to) const
+	{
+		return search(from, to, nullptr);
+	}
+
+	// every tile of the path, both ends included
+	bool findPath(Point from, Point to, std::vector<Point>& path) const
+	{
+		path.clear();
+
+		std::vector<int> doors;
+		if (search(from, to, &doors) < 0)
+			return false;
+
+		path.push_back(from);
+		Point current = from;
+
+		for (int i = 0; i < static_cast<int>(doors.size()); ++i)
+		{
+			const Door& door = _doors[doors[i]];
+			if (current.x == door.position.x && current.y == door.position.y)
+				continue; // the path starts on this door
+
+			int feature = i == 0 ? featureOf(from, door) : shared(_doors[doors[i - 1]], door);
+			walk(current, door.position, feature, path);
+			current = door.position;
+		}
+
+		if (current.x != to.x || current.y != to.y)
+			walk(current, to, doors.empty() ? getFeatureAt(from.x, from.y) : featureOf(to, _doors[doors.back()]), path);
+
+		return true;
+	}
+
+private:
+	struct Step
+	{
+		int cost; // distance so far plus the estimate to the goal
+		int node;
+
+		bool operator>(const Step& other) const
+		{
+			return cost > other.cost;
+		}
+	};
+
+	// doors are stored as negative values in _at, below the -1 of the empty tiles
+	static int doorMark(int door)
+	{
+		return -2 - door;
+	}
+
+	int doorAt(Point p) const
+	{
+		int at = inside(p.x, p.y) ? _at[p.x + p.y * _width] : -1;
+		return at < -1 ? -2 - at : -1;
+	}
+
+	bool inside(int x, int y) const
+	{
+		return x >= 0 && y >= 0 && x < _width && y < _height;
+	}
+
+	static int manhattan(Point a, Point b)
+	{
+		return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+	}
+
+	// closest cell of the feature, the cell just inside for a door
+	Point entry(Point p, int feature) const
+	{
+		const Rect& rect = _features[feature].rect;
+		return Point{ std::min(std::max(p.x, rect.x), rect.x + rect.width - 1), std::min(std::max(p.y, rect.y), rect.y + rect.height - 1) };
+	}
+
+	// steps between two points crossing the feature, each being a cell of it or a door on its side
+	int cross(Point a, Point b, int feature) const
+	{
+		Point inA = entry(a, feature);
+		Point inB = entry(b, feature);
+		return manhattan(a, inA) + manhattan(inA, inB) + manhattan(inB, b);
+	}
+
+	// feature the point is in, or the feature of the door the point is on the other side of
+	int featureOf(Point p, const Door& door) const
+	{
+		int feature = getFeatureAt(p.x, p.y);
+		if (feature >= 0)
+			return feature;
+
+		// p is a door itself, the feature it shares with door
+		const Door& other = _doors[doorAt(p)];
+		return shared(other, door);
+	}
+
+	static int shared(const Door& a, const Door& b)
+	{
+		return a.from == b.from || a.from == b.to ? a.from : a.to;
+	}
+
+	// appends the cells from a (excluded) to b (included) through the feature
+	void walk(Point a, Point b, int feature, std::vector<Point>& path) const
+	{
+		Point inA = entry(a, feature);
+		Point inB = entry(b, feature);
+
+		Point p = a;
+		if (p.x != inA.x || p.y != inA.y)
+		{
+			p = inA;
+			path.push_back(p);
+		}
+
+		// an L is always inside a rectangle holding both of its ends
+		while (p.x != inB.x)
+		{
+			p.x += p.x < inB.x ? 1 : -1;
+			path.push_back(p);
+		}
+		while (p.y != inB.y)
+		{
+			p.y += p.y < inB.y ? 1 : -1;
+			path.push_back(p);
+		}
+
+		if (p.x != b.x || p.y != b.y)
+			path.push_back(b);
+	}
+
+	// A* over the doors, the node after the last door is the goal. Fills doors with the doors crossed in order.
+	int search(Point from, Point to, std::vector<int>* doors) const
+	{
+		int fromFeature = getFeatureAt(from.x, from.y);
+		int toFeature = getFeatureAt(to.x, to.y);
+		int fromDoor = doorAt(from);
+		int toDoor = doorAt(to);
+
+		if ((fromFeature < 0 && fromDoor < 0) || (toFeature < 0 && toDoor < 0))
+			return -1;
+
+		// nothing can be shorter than the manhattan distance inside one rectangle
+		if (fromFeature >= 0 && fromFeature == toFeature)
+		{
+			if (doors)
+				doors->clear();
+			return manhattan(from, to);
+		}
+
+		const int goal = static_cast<int>(_doors.size());
+		std::vector<int> cost(_doors.size() + 1, -1);
+		std::vector<int> previous(_doors.size() + 1, -1);
+		std::vector<bool> closed(_doors.size() + 1, false);
+		std::priority_queue<Step, std::vector<Step>, std::greater<Step>> open;
+
+		auto reach = [&](int node, int nodeCost, int from) {
+			if (cost[node] < 0 || nodeCost < cost[node])
+			{
+				cost[node] = nodeCost;
+				previous[node] = from;
+				int estimate = node == goal ? 0 : manhattan(_doors[node].position, to);
+				open.push(Step{ nodeCost + estimate, node });
+			}
+		};
+
+		if (fromDoor >= 0)
+			reach(fromDoor, 0, -1);
+		else
+			for (int d : _featureDoors[fromFeature])
+				reach(d, cross(from, _doors[d].position, fromFeature), -1);
+
+		while (!open.empty())
+		{
+			int node = open.top().node;
+			open.pop();
+
+			if (closed[node])
+				continue;
+			closed[node] = true;
+
+			if (node == goal)
+				break;
+
+			if (node == toDoor)
+			{
+				reach(goal, cost[node], node);
+				continue;
+			}
+
+			const Door& door = _doors[node];
+			for (int feature : { door.from, door.to })
+			{
+				if (feature == toFeature)
+					reach(goal, cost[node] + cross(door.position, to, feature), node);
+
+				for (int next : _featureDoors[feature])
+					if (next != node && !closed[next])
+						reach(next, cost[node] + cross(door.position, _doors[next].position, feature), node);
+			}
+		}
+
+		if (!closed[goal])
+			return -1;
+
+		if (doors)
+		{
+			doors->clear();
+			for (int node = previous[goal]; node >= 0; node = previous[node])
+				doors->push_back(node);
+			std::reverse(doors->begin(), doors->end());
+		}
+
+		return cost[goal];
+	}
+
+private:
+	int _width, _height;
+	std::vector<Feature> _features;
+	std::vector<Door> _doors;
+	std::vector<std::vector<int>> _featureDoors; // doors on the sides of every feature
+	std::vector<int> _at; // feature of every tile, or doorMark() of the door on it, -1 for neither
+};
@@ -1,8 +1,7 @@
 #pragma once
 
 #include <iostream>
-#include <SFML\Graphics.hpp>
-#include "Player.h"
+#include <SFML/Graphics.hpp>
 
 class Enemy
 {
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "QuadTree.h"
+
+// names an entity of an EntityStore, it stays safe to use after the entity is gone (the store just says it isn't valid)
+struct EntityHandle
+{
+	uint32_t index;
+	uint32_t generation;
+
+	bool operator==(const EntityHandle& other) const
+	{
+		return index == other.index && generation == other.generation;
+	}
+
+	bool operator!=(const EntityHandle& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+// The moving and collectable things of a level, a column per field instead of an sf::RectangleShape per entity :
+// an entity is its axis aligned box and its kind, about 20 bytes. Updates and collision tests walk the float columns
+// and nothing here knows how the entities look, see TileMapRenderer.
+// A removed entity leaves a hole reused by the next one, its generation goes up so old handles stop matching.
+// Each kind also has a quadtree of its boxes for findIntersecting, kept up to date as entities move and go.
+class EntityStore
+{
+public:
+	enum Kind
+	{
+		Coin,
+		Enemy,
+		KindCount
+	};
+
+	EntityStore()
+	{
+		setArea(sf::FloatRect(0.f, 0.f, 0.f, 0.f));
+	}
+
+	// part of the world the quadtrees are cut over, entities out of it are still found, only slower.
+	// The entities already there are put in the new trees by the next query.
+	void setArea(sf::FloatRect area)
+	{
+		for (int kind = 0; kind < KindCount; kind++) {
+			_index[kind].reset(new QuadTree<EntityHandle>(area, 0));
+			_stale[kind] = true;
+		}
+	}
+
+	EntityHandle create(Kind kind, sf::FloatRect bounds)
+	{
+		uint32_t i;
+		if (!_free.empty()) {
+			i = _free.back();
+			_free.pop_back();
+		}
+		else {
+			i = static_cast<uint32_t>(_x.size());
+			_x.push_back(0.f);
+			_y.push_back(0.f);
+			_width.push_back(0.f);
+			_height.push_back(0.f);
+			_kind.push_back(0);
+			_alive.push_back(0);
+			_generation.push_back(0);
+		}
+
+		_x[i] = bounds.left;
+		_y[i] = bounds.top;
+		_width[i] = bounds.width;
+		_height[i] = bounds.height;
+		_kind[i] = static_cast<uint8_t>(kind);
+		_alive[i] = 1;
+		++_counts[kind];
+
+		EntityHandle handle{ i, _generation[i] };
+		if (!_stale[kind])
+			_index[kind]->insert(handle, bounds);
+		return handle;
+	}
+
+	// false if the entity was already removed
+	bool destroy(EntityHandle handle)
+	{
+		if (!isValid(handle))
+			return false;
+
+		const Kind kind = getKind(handle);
+		if (!_stale[kind])
+			_index[kind]->remove(handle, getBounds(handle));
+
+		_alive[handle.index] = 0;
+		++_generation[handle.index];
+		--_counts[kind];
+		_free.push_back(handle.index);
+		return true;
+	}
+
+	bool isValid(EntityHandle handle) const
+	{
+		return handle.index < _alive.size() && _alive[handle.index] != 0 && _generation[handle.index] == handle.generation;
+	}
+
+	void clear()
+	{
+		_x.clear();
+		_y.clear();
+		_width.clear();
+		_height.clear();
+		_kind.clear();
+		_alive.clear();
+		_generation.clear();
+		_free.clear();
+		for (int& count : _counts)
+			count = 0;
+		for (int kind = 0; kind < KindCount; kind++) {
+			_index[kind]->clear();
+			_stale[kind] = false;
+		}
+	}
+
+	sf::Vector2f getPosition(EntityHandle handle) const
+	{
+		return sf::Vector2f(_x[handle.index], _y[handle.index]);
+	}
+
+	// the entity only changes node in the quadtree when it leaves the one it is in
+	void setPosition(EntityHandle handle, sf::Vector2f position)
+	{
+		const Kind kind = getKind(handle);
+		if (!_stale[kind])
+			_index[kind]->update(handle, getBounds(handle), sf::FloatRect(position.x, position.y, _width[handle.index], _height[handle.index]));
+
+		_x[handle.index] = position.x;
+		_y[handle.index] = position.y;
+	}
+
+	sf::FloatRect getBounds(EntityHandle handle) const
+	{
+		return sf::FloatRect(_x[handle.index], _y[handle.index], _width[handle.index], _height[handle.index]);
+	}
+
+	Kind getKind(EntityHandle handle) const
+	{
+		return static_cast<Kind>(_kind[handle.index]);
+	}
+
+	int count(Kind kind) const
+	{
+		return _counts[kind];
+	}
+
+	// every slot, removed ones included, for the loops below
+	int getSlotCount() const
+	{
+		return static_cast<int>(_x.size());
+	}
+
+	bool isAlive(int slot, Kind kind) const
+	{
+		return _alive[slot] != 0 && _kind[slot] == kind;
+	}
+
+	EntityHandle getHandle(int slot) const
+	{
+		return EntityHandle{ static_cast<uint32_t>(slot), _generation[slot] };
+	}
+
+	float getX(int slot) const
+	{
+		return _x[slot];
+	}
+
+	float getY(int slot) const
+	{
+		return _y[slot];
+	}
+
+	// calls visit(handle) for every entity of the kind, it may move or remove that entity
+	template <typename Visit>
+	void forEach(Kind kind, Visit visit)
+	{
+		const int slots = getSlotCount();
+		for (int i = 0; i < slots; ++i)
+			if (isAlive(i, kind))
+				visit(getHandle(i));
+	}
+
+	// entities of the kind whose box overlaps the given one, from the quadtree of the kind
+	void findIntersecting(Kind kind, sf::FloatRect box, std::vector<EntityHandle>& result) const
+	{
+		if (_stale[kind])
+			rebuild(kind);
+
+		_index[kind]->getObjects(box, result);
+	}
+
+	size_t getMemorySize() const
+	{
+		return _x.capacity() * sizeof(float) * 4
+			+ _kind.capacity() + _alive.capacity()
+			+ _generation.capacity() * sizeof(uint32_t)
+			+ _free.capacity() * sizeof(uint32_t);
+	}
+
+private:
+	void rebuild(Kind kind) const
+	{
+		_index[kind]->clear();
+
+		const int slots = getSlotCount();
+		for (int i = 0; i < slots; ++i)
+			if (isAlive(i, kind))
+				_index[kind]->insert(getHandle(i), sf::FloatRect(_x[i], _y[i], _width[i], _height[i]));
+
+		_stale[kind] = false;
+	}
+
+private:
+	std::vector<float> _x, _y; // top left corner
+	std::vector<float> _width, _height;
+	std::vector<uint8_t> _kind;
+	std::vector<uint8_t> _alive;
+	std::vector<uint32_t> _generation;
+	std::vector<uint32_t> _free; // removed slots, reused first
+	int _counts[KindCount] = {};
+	// built again by the next query after setArea
+	mutable std::unique_ptr<QuadTree<EntityHandle>> _index[KindCount];
+	mutable bool _stale[KindCount];
+};
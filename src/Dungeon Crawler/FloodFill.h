@@ -0,0 +1,387 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "TileGrid.h"
+
+// Reachability and distances over a TileGrid, 64 tiles at a time.
+// The walkable tiles are packed in one bit per tile, and a step of the flood moves 64 tiles of the frontier at once
+// with shifts instead of visiting the tiles one by one. Every row ends with at least one never walkable word,
+// so the shifts can carry between neighbour words without checking for the end of the row.
+// A mask is a bitset with that same layout, see makeMask().
+// It can be limited to an area of the grid (its left side rounded down to a multiple of 64), coordinates stay those of the grid.
+class FloodFill
+{
+public:
+	// passableCodes has the bit (1 << code) set for every walkable tile code, a negative size goes to the end of the grid
+	FloodFill(const TileGrid& tiles, unsigned int passableCodes, int left = 0, int top = 0, int width = -1, int height = -1)
+		: _left(left & ~63)
+		, _top(top)
+		, _width((width < 0 ? tiles.getWidth() : std::min(left + width, tiles.getWidth())) - (left & ~63))
+		, _height(height < 0 ? tiles.getHeight() - top : height)
+		, _rowWords(_width / 64 + 1)
+		, _passable(_rowWords* _height, 0)
+	{
+		// walkable bits of the two tiles of every byte value
+		unsigned char pairs[256];
+		for (int b = 0; b < 256; ++b)
+			pairs[b] = static_cast<unsigned char>((passableCodes >> (b & 15) & 1) | (passableCodes >> (b >> 4) & 1) << 1);
+
+		// the grid words of the area, 4 per word of _passable
+		const int firstWord = _left / TileGrid::tilesPerWord;
+		const int wordCount = std::min((_width + TileGrid::tilesPerWord - 1) / TileGrid::tilesPerWord, tiles.getRowWords() - firstWord);
+
+		for (int y = 0; y < _height; ++y)
+		{
+			const uint64_t* row = tiles.row(_top + y) + firstWord;
+
+			for (int w = 0; w < wordCount; ++w)
+			{
+				// 16 times the same tile is common (unused space), it doesn't need to be looked at byte by byte
+				uint64_t bits = 0;
+				int code = row[w] & 15;
+				if (row[w] == code * TileGrid::lowNibbles())
+					bits = passableCodes >> code & 1 ? 0xFFFF : 0;
+				else
+					for (int b = 0; b < 8; ++b)
+						bits |= uint64_t(pairs[(row[w] >> (b * 8)) & 255]) << (b * 2);
+
+				_passable[(w >> 2) + y * _rowWords] |= bits << ((w & 3) * 16);
+			}
+
+			// the tiles right of the area (or the padding of the grid) must not be walkable
+			if (_width % 64 != 0)
+				_passable[_width / 64 + y * _rowWords] &= (uint64_t(1) << (_width % 64)) - 1;
+		}
+	}
+
+	int getLeft() const
+	{
+		return _left;
+	}
+
+	int getTop() const
+	{
+		return _top;
+	}
+
+	int getWidth() const
+	{
+		return _width;
+	}
+
+	int getHeight() const
+	{
+		return _height;
+	}
+
+	bool isPassable(int x, int y) const
+	{
+		return inside(x, y) && testBit(_passable, x, y);
+	}
+
+	std::vector<uint64_t> makeMask() const
+	{
+		return std::vector<uint64_t>(_passable.size(), 0);
+	}
+
+	void setBit(std::vector<uint64_t>& mask, int x, int y) const
+	{
+		mask[index(x, y)] |= uint64_t(1) << (x & 63);
+	}
+
+	bool testBit(const std::vector<uint64_t>& mask, int x, int y) const
+	{
+		return (mask[index(x, y)] >> (x & 63)) & 1;
+	}
+
+	// Every tile connected to (x, y). Rows are swept down then up, each row taking what its neighbour row reached
+	// and filling its walkable runs in a few shifts, until a round changes nothing.
+	std::vector<uint64_t> reach(int x, int y) const
+	{
+		std::vector<uint64_t> reached = makeMask();
+		if (!isPassable(x, y))
+			return reached;
+
+		int start = index(x, y);
+		setBit(reached, x, y);
+		fillRuns(&reached[start - start % _rowWords], &_passable[start - start % _rowWords], start % _rowWords, start % _rowWords);
+
+		// sweep in which every row last grew, a row only pulls from a neighbour that grew since it last pulled from it
+		// (the start row counts as grown in both of the first two sweeps)
+		std::vector<int> grown(_height, -1);
+		grown[y - _top] = 1;
+
+		bool changed = true;
+		for (int sweep = 1; changed || sweep <= 2; ++sweep)
+		{
+			changed = false;
+			bool down = sweep % 2 == 1;
+
+			for (int i = 0; i < _height; ++i)
+			{
+				int row = down ? i : _height - 1 - i;
+				int from = down ? row - 1 : row + 1;
+
+				if (from >= 0 && from < _height && grown[from] >= sweep - 1 && fillRow(reached, row, from))
+				{
+					grown[row] = sweep;
+					changed = true;
+				}
+			}
+		}
+
+		return reached;
+	}
+
+	bool isReachable(int fromX, int fromY, int toX, int toY) const
+	{
+		return isPassable(toX, toY) && testBit(reach(fromX, fromY), toX, toY);
+	}
+
+	int countReachable(int x, int y) const
+	{
+		int total = 0;
+		for (uint64_t word : reach(x, y))
+			total += TileGrid::bitCount(word);
+
+		return total;
+	}
+
+	// steps between the two tiles, -1 if there is no path
+	int distance(int fromX, int fromY, int toX, int toY) const
+	{
+		if (!isPassable(toX, toY))
+			return -1;
+
+		int result = -1;
+		int target = index(toX, toY);
+
+		expand(fromX, fromY, [&](int layer, int i, uint64_t bits) {
+			if (i == target && ((bits >> (toX & 63)) & 1))
+			{
+				result = layer;
+				return false;
+			}
+			return true;
+		});
+
+		return result;
+	}
+
+	// distance of every tile of the area from (x, y) in steps, row by row, -1 where it can't be reached
+	void distances(int x, int y, std::vector<int>& result) const
+	{
+		result.assign(_width * _height, -1);
+
+		expand(x, y, [&](int layer, int i, uint64_t bits) {
+			int* row = &result[(i / _rowWords) * _width + (i % _rowWords) * 64];
+			for (; bits != 0; bits &= bits - 1)
+				row[lowestBit(bits)] = layer;
+			return true;
+		});
+	}
+
+	// tile of targets the farthest from (x, y), returns its distance or -1 when no target can be reached
+	int farthest(int x, int y, const std::vector<uint64_t>& targets, int& resultX, int& resultY) const
+	{
+		int result = -1;
+
+		expand(x, y, [&](int layer, int i, uint64_t bits) {
+			bits &= targets[i];
+			if (bits != 0 && layer > result)
+			{
+				result = layer;
+				resultX = _left + (i % _rowWords) * 64 + lowestBit(bits);
+				resultY = _top + i / _rowWords;
+			}
+			return true;
+		});
+
+		return result;
+	}
+
+private:
+	bool inside(int x, int y) const
+	{
+		return x >= _left && y >= _top && x < _left + _width && y < _top + _height;
+	}
+
+	// word of the tile in the masks, its bit is x & 63 since the area starts on a multiple of 64
+	int index(int x, int y) const
+	{
+		return ((x - _left) >> 6) + (y - _top) * _rowWords;
+	}
+
+	// Breadth first search, one layer of the frontier at a time. Only the words next to the frontier are looked at.
+	// visit(layer, word index, bits) gets the tiles first reached at that layer, and stops the search by returning false.
+	template <typename Visit>
+	void expand(int x, int y, Visit visit) const
+	{
+		if (!isPassable(x, y))
+			return;
+
+		std::vector<uint64_t> visited = makeMask();
+		std::vector<uint64_t> frontier = makeMask();
+		std::vector<uint64_t> next = makeMask();
+		const int size = static_cast<int>(_passable.size());
+		std::vector<int> words(1, index(x, y)), nextWords, touched;
+
+		// ors bits into the next layer, remembering the words it touches
+		auto spread = [&](int i, uint64_t bits) {
+			if (bits != 0 && i >= 0 && i < size)
+			{
+				if (next[i] == 0)
+					touched.push_back(i);
+				next[i] |= bits;
+			}
+		};
+
+		setBit(visited, x, y);
+		setBit(frontier, x, y);
+		if (!visit(0, words[0], uint64_t(1) << (x & 63)))
+			return;
+
+		for (int layer = 1; !words.empty(); ++layer)
+		{
+			// every frontier word pushes its bits one step in the 4 directions,
+			// the carries between words may cross to another row, but then one of the two is the row's guard word
+			touched.clear();
+			for (int i : words)
+			{
+				uint64_t bits = frontier[i];
+				frontier[i] = 0;
+
+				spread(i, bits << 1 | bits >> 1);
+				spread(i + 1, bits >> 63);
+				spread(i - 1, bits << 63);
+				spread(i - _rowWords, bits);
+				spread(i + _rowWords, bits);
+			}
+
+			nextWords.clear();
+			for (int i : touched)
+			{
+				uint64_t bits = next[i] & _passable[i] & ~visited[i];
+				next[i] = 0;
+
+				if (bits != 0)
+				{
+					frontier[i] = bits;
+					visited[i] |= bits;
+					nextWords.push_back(i);
+
+					if (!visit(layer, i, bits))
+						return;
+				}
+			}
+
+			words.swap(nextWords);
+		}
+	}
+
+	// adds to the row what the other row reached above or below it, then fills its walkable runs, true if it grew
+	bool fillRow(std::vector<uint64_t>& reached, int row, int from) const
+	{
+		uint64_t* r = &reached[row * _rowWords];
+		const uint64_t* p = &_passable[row * _rowWords];
+		const uint64_t* f = from >= 0 && from < _height ? &reached[from * _rowWords] : nullptr;
+
+		if (f == nullptr)
+			return false;
+
+		int first = -1, last = -1;
+		for (int w = 0; w < _rowWords; ++w)
+		{
+			uint64_t seeds = f[w] & p[w] & ~r[w];
+			if (seeds != 0)
+			{
+				r[w] |= seeds;
+				if (first < 0)
+					first = w;
+				last = w;
+			}
+		}
+
+		if (first < 0)
+			return false;
+
+		fillRuns(r, p, first, last);
+		return true;
+	}
+
+	// grows the reached bits of the words first..last of a row to the whole walkable runs they are on,
+	// toward higher x then back toward lower x, carrying across words only as long as a run goes on
+	void fillRuns(uint64_t* r, const uint64_t* p, int first, int last) const
+	{
+		uint64_t carry = 0;
+		int w = first;
+		for (; w < _rowWords && (w <= last || carry != 0); ++w)
+		{
+			r[w] = fillUp(r[w] | carry, p[w]);
+			carry = r[w] >> 63;
+		}
+
+		carry = 0;
+		for (w = w - 1; w >= 0 && (w >= first || carry != 0); --w)
+		{
+			r[w] = fillDown(r[w] | carry << 63, p[w]);
+			carry = r[w] & 1;
+		}
+	}
+
+	// spreads the bits of gen toward the high bits while they stay on pro (Kogge-Stone occluded fill)
+	static uint64_t fillUp(uint64_t gen, uint64_t pro)
+	{
+		gen &= pro;
+		gen |= pro & (gen << 1);
+		pro &= pro << 1;
+		gen |= pro & (gen << 2);
+		pro &= pro << 2;
+		gen |= pro & (gen << 4);
+		pro &= pro << 4;
+		gen |= pro & (gen << 8);
+		pro &= pro << 8;
+		gen |= pro & (gen << 16);
+		pro &= pro << 16;
+		gen |= pro & (gen << 32);
+		return gen;
+	}
+
+	static uint64_t fillDown(uint64_t gen, uint64_t pro)
+	{
+		gen &= pro;
+		gen |= pro & (gen >> 1);
+		pro &= pro >> 1;
+		gen |= pro & (gen >> 2);
+		pro &= pro >> 2;
+		gen |= pro & (gen >> 4);
+		pro &= pro >> 4;
+		gen |= pro & (gen >> 8);
+		pro &= pro >> 8;
+		gen |= pro & (gen >> 16);
+		pro &= pro >> 16;
+		gen |= pro & (gen >> 32);
+		return gen;
+	}
+
+	// index of the lowest set bit (de Bruijn multiplication), x must not be 0
+	static int lowestBit(uint64_t x)
+	{
+		static const int index[64] = {
+			0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+			62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+			63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+			46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+		};
+
+		return index[((x & (~x + 1)) * 0x03F79D71B4CB0A89ull) >> 58];
+	}
+
+private:
+	int _left, _top;
+	int _width, _height;
+	int _rowWords;
+	std::vector<uint64_t> _passable;
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Dijkstra map toward a single target (the player) : every walkable tile within maxDistance steps knows its distance
+// to the target and the neighbour to step on to get closer, so any number of enemies can follow it for one lookup each.
+// The field is not updated incrementally : when the target changes tile, the tiles reached by the previous build are cleared
+// and a new breadth first search runs from the target, stopping at maxDistance steps. A rebuild costs the tiles within
+// maxDistance of the target rather than the whole map. When the target moves one tile, about every one of those tiles
+// changes distance by one anyway, so relaxing only the changed tiles would visit nearly as many.
+class FlowField
+{
+public:
+	static const uint16_t unreached = 0xFFFF;
+
+	FlowField()
+		: FlowField(0, 0)
+	{
+	}
+
+	FlowField(int width, int height, int maxDistance = unreached - 1)
+		: _width(width)
+		, _height(height)
+		, _maxDistance(maxDistance)
+		, _targetX(-1)
+		, _targetY(-1)
+		, _walkable(width* height, 0)
+		, _distance(width* height, uint16_t(unreached))
+		, _step(width* height, -1)
+		, _reached()
+	{
+	}
+
+	int getWidth() const
+	{
+		return _width;
+	}
+
+	int getHeight() const
+	{
+		return _height;
+	}
+
+	void setWalkable(int x, int y, bool walkable)
+	{
+		_walkable[x + y * _width] = walkable ? 1 : 0;
+	}
+
+	bool isWalkable(int x, int y) const
+	{
+		return inside(x, y) && _walkable[x + y * _width] != 0;
+	}
+
+	// rebuilds the field from scratch, within maxDistance, if the target moved to another tile. Returns true when it did
+	bool setTarget(int x, int y)
+	{
+		if (x == _targetX && y == _targetY)
+			return false;
+
+		_targetX = x;
+		_targetY = y;
+
+		for (int i : _reached)
+		{
+			_distance[i] = unreached;
+			_step[i] = -1;
+		}
+		_reached.clear();
+
+		if (!isWalkable(x, y))
+			return true;
+
+		// breadth first, _reached doubles as the queue
+		_distance[x + y * _width] = 0;
+		_reached.push_back(x + y * _width);
+
+		for (size_t head = 0; head < _reached.size(); ++head)
+		{
+			int i = _reached[head];
+			if (_distance[i] >= _maxDistance)
+				continue;
+
+			int tileX = i % _width;
+			int tileY = i / _width;
+
+			for (int d = 0; d < 4; ++d)
+			{
+				int nx = tileX + offsetX(d);
+				int ny = tileY + offsetY(d);
+				int n = nx + ny * _width;
+
+				if (isWalkable(nx, ny) && _distance[n] == unreached)
+				{
+					_distance[n] = _distance[i] + 1;
+					_step[n] = static_cast<int8_t>(opposite(d));
+					_reached.push_back(n);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	int getTargetX() const
+	{
+		return _targetX;
+	}
+
+	int getTargetY() const
+	{
+		return _targetY;
+	}
+
+	// steps to the target, -1 when out of reach
+	int getDistance(int x, int y) const
+	{
+		if (!inside(x, y) || _distance[x + y * _width] == unreached)
+			return -1;
+
+		return _distance[x + y * _width];
+	}
+
+	// neighbour one step closer to the target, false on the target itself or out of reach
+	bool nextStep(int x, int y, int& nextX, int& nextY) const
+	{
+		if (!inside(x, y) || _step[x + y * _width] < 0)
+			return false;
+
+		nextX = x + offsetX(_step[x + y * _width]);
+		nextY = y + offsetY(_step[x + y * _width]);
+		return true;
+	}
+
+	// tiles of the last build, also the ones the next build will clear
+	int getReachedCount() const
+	{
+		return static_cast<int>(_reached.size());
+	}
+
+private:
+	// north, south, west, east, each direction and its opposite differ by the low bit
+	static int offsetX(int d)
+	{
+		static const int x[4] = { 0, 0, -1, 1 };
+		return x[d];
+	}
+
+	static int offsetY(int d)
+	{
+		static const int y[4] = { -1, 1, 0, 0 };
+		return y[d];
+	}
+
+	static int opposite(int d)
+	{
+		return d ^ 1;
+	}
+
+	bool inside(int x, int y) const
+	{
+		return x >= 0 && y >= 0 && x < _width && y < _height;
+	}
+
+private:
+	int _width, _height;
+	int _maxDistance;
+	int _targetX, _targetY;
+	std::vector<uint8_t> _walkable;
+	std::vector<uint16_t> _distance;
+	std::vector<int8_t> _step; // direction of the next step (see offsetX), -1 for none
+	std::vector<int> _reached; // tiles with a distance, in the order they were reached
+};
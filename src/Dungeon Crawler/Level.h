@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "Dungeon.h"
+#include "EntityStore.h"
+#include "FlowField.h"
+#include "LevelFile.h"
+#include "Logger.h"
+#include "QuadTree.h"
+#include "Random.h"
+#include "TileGrid.h"
+
+// One floor of the dungeon, fully built : the box of every wall and of the stairs, coins and enemies in an EntityStore,
+// and the quadtree of the walls. A wall is only its sf::FloatRect, collisions are tested against the boxes themselves.
+// Nothing here touches the window or a texture, everything is drawn by a TileMapRenderer from the boxes kept here,
+// so a floor can be built on a background thread while this one is played, even before the textures are loaded.
+class Level
+{
+public:
+	static const int width = 70;
+	static const int height = 20;
+	static const int maxFeatures = 15;
+	static const int chaseRadius = 20; // enemies farther than this many steps from the player don't move
+
+	// an empty level has no tiles at all, the infinite mode gets its walls from ChunkedWorld instead
+	Level(unsigned int seed, float blocSize, bool empty = false)
+		: _seed(seed)
+		, _width(empty ? 0 : width)
+		, _height(empty ? 0 : height)
+		, _blocSize(blocSize)
+		, _stairs(outOfReach(blocSize))
+	{
+		if (empty) {
+			// there is no way down in an empty level
+			_quadTree.reset(new QuadTree<sf::FloatRect>(sf::FloatRect(0.f, 0.f, 0.f, 0.f), 0));
+			return;
+		}
+
+		Dungeon d(width, height, seed);
+		d.generate(maxFeatures);
+		//d.print();
+		_tiles = d.getTiles().getGrid();
+		_rooms = d.getRooms();
+		_exits = d.getExits();
+
+		Dungeon::TileView tiles = d.getTiles();
+		std::vector<int> emptyTiles;
+		emptyTiles.reserve(tiles.count(' '));
+		int i = 0;
+		for (char tile : tiles) {
+			//If Tile = Character
+			if (tile == '>')
+				_spawns.push_back(LevelSpawn{ uint16_t(i % width), uint16_t(i / width), LevelSpawn::Player, 0 });
+			//If Tile = Stairs
+			if (tile == '<')
+				_spawns.push_back(LevelSpawn{ uint16_t(i % width), uint16_t(i / width), LevelSpawn::Stairs, 0 });
+			//Generate coin or monster on empty space
+			if (tile == ' ')
+				emptyTiles.push_back(i);
+			++i;
+		}
+
+		// coins and enemies get their own engine so the spawns are reproducible from the seed too
+		Random spawnRandom(seed ^ 0x5bd1e995u);
+		int maxEnemyPerLevel = spawnRandom.randomInt(5);
+		int maxCoinPerLevel = spawnRandom.randomInt(5);
+
+		for (int i = 0; i < static_cast<int>(emptyTiles.size()) && i <= maxCoinPerLevel; i++) {
+			int tile = emptyTiles[spawnRandom.randomInt(emptyTiles.size())];
+			_spawns.push_back(LevelSpawn{ uint16_t(tile % width), uint16_t(tile / width), LevelSpawn::Coin, 0 });
+		}
+		for (int i = 0; i < static_cast<int>(emptyTiles.size()) && i <= maxEnemyPerLevel; i++) {
+			int tile = emptyTiles[spawnRandom.randomInt(emptyTiles.size())];
+			LOG_TRACE("enemy spawn at " << tile % width << ", " << tile / width);
+			_spawns.push_back(LevelSpawn{ uint16_t(tile % width), uint16_t(tile / width), LevelSpawn::Enemy, 0 });
+		}
+
+		_walls.reserve(tiles.count(Dungeon::Wall));
+		build(tiles, _spawns.data(), static_cast<int>(_spawns.size()), blocSize);
+	}
+
+	// a floor saved with save(), the tiles are read in place from the mapped file. Null if the file can't be opened.
+	static std::unique_ptr<Level> load(const std::string& path, float blocSize)
+	{
+		std::unique_ptr<LevelFile> file(new LevelFile());
+		if (!file->open(path))
+			return nullptr;
+
+		return std::unique_ptr<Level>(new Level(std::move(file), blocSize));
+	}
+
+	Level(const Level&) = delete;
+	Level& operator=(const Level&) = delete;
+
+	// seed of the given floor (1 for the first one) of a run started with runSeed
+	static unsigned int floorSeed(unsigned int runSeed, int floor)
+	{
+		return runSeed + (floor - 1) * 0x9E3779B9u;
+	}
+
+	// only generated levels keep their tiles around, a loaded level is already a file
+	bool save(const std::string& path) const {
+		if (_tiles.getWidth() == 0)
+			return false;
+
+		return LevelFile::save(path, _seed, _tiles, _rooms, _exits, _spawns);
+	}
+
+	// every enemy walks one step of the flow field toward the player, the field is only rebuilt when the player changes tile
+	void moveEnemies(sf::Vector2f playerCenter, float deltaTime) {
+		const float enemySpeed = 60.f;
+
+		_flowField.setTarget(static_cast<int>(std::floor(playerCenter.x / _blocSize)), static_cast<int>(std::floor(playerCenter.y / _blocSize)));
+
+		_entities.forEach(EntityStore::Enemy, [&](EntityHandle enemy) {
+			_entities.setPosition(enemy, chaseStep(_flowField, _entities.getPosition(enemy), playerCenter, _blocSize, enemySpeed * deltaTime));
+		});
+	}
+
+	// position (top left corner) of an enemy after walking distance pixels along the field, toward the corner of the
+	// next tile, or straight to the target once on its tile. An enemy out of the field stays where it is.
+	static sf::Vector2f chaseStep(const FlowField& field, sf::Vector2f position, sf::Vector2f target, float blocSize, float distance) {
+		int x = static_cast<int>(std::floor(position.x / blocSize + 0.5f));
+		int y = static_cast<int>(std::floor(position.y / blocSize + 0.5f));
+		if (field.getDistance(x, y) < 0)
+			return position;
+
+		sf::Vector2f goal(target.x - blocSize / 2, target.y - blocSize / 2);
+		int nextX, nextY;
+		if (field.nextStep(x, y, nextX, nextY))
+			goal = sf::Vector2f(nextX * blocSize, nextY * blocSize);
+
+		sf::Vector2f delta = goal - position;
+		float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+		if (length <= distance)
+			return goal;
+
+		return position + delta * (distance / length);
+	}
+
+	const FlowField& getFlowField() const {
+		return _flowField;
+	}
+
+	// the box of every wall
+	const std::vector<sf::FloatRect>& getWalls() const {
+		return _walls;
+	}
+
+	// coins and enemies, a coin picked up or an enemy hit is removed from it
+	EntityStore& getEntities() {
+		return _entities;
+	}
+
+	// box of the stairs, centered on the corner of their tile
+	sf::FloatRect getStairs() const {
+		return _stairs;
+	}
+
+	const QuadTree<sf::FloatRect>& getQuadTree() const {
+		return *_quadTree;
+	}
+
+	sf::Vector2f getPlayerStart() const {
+		return _playerStart;
+	}
+
+	unsigned int getSeed() const {
+		return _seed;
+	}
+
+private:
+	// a level file already opened, see load()
+	Level(std::unique_ptr<LevelFile> file, float blocSize)
+		: _seed(file->getHeader().seed)
+		, _width(file->getHeader().width)
+		, _height(file->getHeader().height)
+		, _blocSize(blocSize)
+		, _stairs(outOfReach(blocSize))
+		, _file(std::move(file))
+	{
+		const LevelFile& levelFile = *_file;
+		build([&levelFile](int x, int y) { return levelFile.getTile(x, y); }, levelFile.getSpawns(), levelFile.getHeader().spawnCount, blocSize);
+	}
+
+	// where the stairs are until a spawn puts them somewhere
+	static sf::FloatRect outOfReach(float blocSize)
+	{
+		return sf::FloatRect(999999.f, 999999.f, blocSize, blocSize);
+	}
+
+	// creates the entities from the tiles and the spawns, whatever they come from
+	template <typename TileAt>
+	void build(TileAt tileAt, const LevelSpawn* spawns, int spawnCount, float blocSize)
+	{
+		_quadTree.reset(new QuadTree<sf::FloatRect>(sf::FloatRect(0.f, 0.f, _width * blocSize, _height * blocSize), 0));
+		_entities.setArea(sf::FloatRect(0.f, 0.f, _width * blocSize, _height * blocSize));
+		_flowField = FlowField(_width, _height, chaseRadius);
+
+		for (int y = 0; y < _height; y++) {
+			for (int x = 0; x < _width; x++) {
+				char tile = tileAt(x, y);
+
+				// enemies walk on everything but the walls and the void around the rooms
+				_flowField.setWalkable(x, y, (Dungeon::walkableCodes() >> Dungeon::tileCode(tile) & 1) != 0);
+
+				//If Tile = Wall
+				if (tile == '#') {
+					_walls.push_back(sf::FloatRect(x * blocSize, y * blocSize, blocSize, blocSize));
+					LOG_TRACE("wall at " << x * blocSize << ", " << y * blocSize);
+				}
+			}
+		}
+
+		for (int i = 0; i < spawnCount; i++) {
+			const LevelSpawn& spawn = spawns[i];
+			if (spawn.x >= _width || spawn.y >= _height)
+				continue;
+
+			sf::Vector2f position(spawn.x * blocSize, spawn.y * blocSize);
+
+			if (spawn.kind == LevelSpawn::Player) {
+				_playerStart = position;
+			}
+			else if (spawn.kind == LevelSpawn::Stairs) {
+				_stairs = sf::FloatRect(position.x - blocSize / 2, position.y - blocSize / 2, blocSize, blocSize);
+			}
+			else if (spawn.kind == LevelSpawn::Coin) {
+				_entities.create(EntityStore::Coin, sf::FloatRect(position, sf::Vector2f(blocSize, blocSize)));
+			}
+			else if (spawn.kind == LevelSpawn::Enemy) {
+				_entities.create(EntityStore::Enemy, sf::FloatRect(position, sf::Vector2f(blocSize, blocSize)));
+			}
+		}
+
+		// Add objects in the quadTree
+		for (const sf::FloatRect& wall : _walls) {
+			_quadTree->insert(wall);
+		}
+	}
+
+private:
+	unsigned int _seed;
+	int _width, _height;
+	float _blocSize;
+	TileGrid _tiles; // packed as in the dungeon, only to save the level
+	std::vector<Rect> _rooms;
+	std::vector<Rect> _exits;
+	std::vector<LevelSpawn> _spawns;
+	std::vector<sf::FloatRect> _walls;
+	EntityStore _entities;
+	sf::FloatRect _stairs;
+	sf::Vector2f _playerStart;
+	std::unique_ptr<QuadTree<sf::FloatRect>> _quadTree; // a copy of every wall box
+	FlowField _flowField;
+	std::unique_ptr<LevelFile> _file;
+};
@@ -0,0 +1,175 @@
+#include "LevelFile.h"
+#include <cstring>
+#include <fstream>
+#include "Logger.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	uint32_t align4(uint32_t offset)
+	{
+		return (offset + 3) & ~uint32_t(3);
+	}
+}
+
+LevelFile::LevelFile() :
+	_data(nullptr),
+	_size(0),
+	_file(nullptr),
+	_mapping(nullptr)
+{
+}
+
+LevelFile::~LevelFile()
+{
+	close();
+}
+
+bool LevelFile::save(const std::string& path, unsigned int seed, const TileGrid& tiles,
+	const std::vector<Rect>& rooms, const std::vector<Rect>& exits, const std::vector<LevelSpawn>& spawns) {
+
+	static_assert(sizeof(Header) % 4 == 0 && sizeof(Rect) == 16 && sizeof(LevelSpawn) == 8, "level file layout");
+
+	int width = tiles.getWidth();
+	int height = tiles.getHeight();
+
+	Header header = {};
+	header.magic = magic;
+	header.version = version;
+	header.seed = seed;
+	header.width = static_cast<uint16_t>(width);
+	header.height = static_cast<uint16_t>(height);
+	header.rowBytes = (width + 1) / 2;
+	header.tilesOffset = sizeof(Header);
+	header.roomsOffset = align4(header.tilesOffset + header.rowBytes * height);
+	header.roomCount = static_cast<uint32_t>(rooms.size());
+	header.exitsOffset = header.roomsOffset + header.roomCount * sizeof(Rect);
+	header.exitCount = static_cast<uint32_t>(exits.size());
+	header.spawnsOffset = header.exitsOffset + header.exitCount * sizeof(Rect);
+	header.spawnCount = static_cast<uint32_t>(spawns.size());
+	header.fileSize = header.spawnsOffset + header.spawnCount * sizeof(LevelSpawn);
+
+	// the whole file is built in memory and written at once
+	std::vector<unsigned char> bytes(header.fileSize, 0);
+	std::memcpy(&bytes[0], &header, sizeof(Header));
+
+	// same nibble order as the grid, a row is its words cut to rowBytes
+	for (int y = 0; y < height; ++y) {
+		const uint64_t* row = tiles.row(y);
+		for (uint32_t b = 0; b < header.rowBytes; ++b)
+			bytes[header.tilesOffset + y * header.rowBytes + b] = static_cast<unsigned char>(row[b / 8] >> (b % 8 * 8));
+	}
+
+	if (!rooms.empty())
+		std::memcpy(&bytes[header.roomsOffset], rooms.data(), rooms.size() * sizeof(Rect));
+	if (!exits.empty())
+		std::memcpy(&bytes[header.exitsOffset], exits.data(), exits.size() * sizeof(Rect));
+	if (!spawns.empty())
+		std::memcpy(&bytes[header.spawnsOffset], spawns.data(), spawns.size() * sizeof(LevelSpawn));
+
+	std::ofstream out(path, std::ios::binary);
+	out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+	if (!out) {
+		LOG_ERROR("Unable to save level " << path);
+		return false;
+	}
+	return true;
+}
+
+bool LevelFile::open(const std::string& path) {
+
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		LOG_ERROR("Unable to open level " << path);
+		return false;
+	}
+	_file = file;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	_size = static_cast<size_t>(size.QuadPart);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping != nullptr) {
+		_mapping = mapping;
+		_data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		LOG_ERROR("Unable to open level " << path);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0) {
+		_size = static_cast<size_t>(info.st_size);
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED)
+			_data = static_cast<const unsigned char*>(data);
+	}
+
+	// the mapping stays valid once the descriptor is closed
+	::close(file);
+#endif
+
+	if (_data == nullptr || !isValid()) {
+		LOG_ERROR("Invalid level file " << path);
+		close();
+		return false;
+	}
+	return true;
+}
+
+void LevelFile::close() {
+
+#ifdef _WIN32
+	if (_data != nullptr)
+		UnmapViewOfFile(_data);
+	if (_mapping != nullptr)
+		CloseHandle(_mapping);
+	if (_file != nullptr)
+		CloseHandle(_file);
+#else
+	if (_data != nullptr)
+		munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+	_file = nullptr;
+	_mapping = nullptr;
+}
+
+bool LevelFile::isValid() const {
+
+	if (_size < sizeof(Header))
+		return false;
+
+	// every section has to lie inside the file before anything is read in place
+	const Header& header = getHeader();
+	return header.magic == magic &&
+		header.version == version &&
+		header.fileSize == _size &&
+		header.rowBytes == (header.width + 1u) / 2 &&
+		header.tilesOffset >= sizeof(Header) &&
+		header.tilesOffset + uint64_t(header.rowBytes) * header.height <= header.roomsOffset &&
+		header.roomsOffset + uint64_t(header.roomCount) * sizeof(Rect) <= header.exitsOffset &&
+		header.exitsOffset + uint64_t(header.exitCount) * sizeof(Rect) <= header.spawnsOffset &&
+		header.spawnsOffset + uint64_t(header.spawnCount) * sizeof(LevelSpawn) <= _size &&
+		header.roomsOffset % 4 == 0 && header.exitsOffset % 4 == 0 && header.spawnsOffset % 4 == 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Dungeon.h"
+#include "TileGrid.h"
+
+// what stands on a tile when the level starts
+struct LevelSpawn
+{
+	enum Kind
+	{
+		Player,
+		Stairs,
+		Coin,
+		Enemy
+	};
+
+	uint16_t x, y; // tile coordinates
+	uint16_t kind;
+	uint16_t padding;
+};
+
+// Binary save of one floor, read in place from a memory mapped file.
+// Layout (little endian, every section 4 byte aligned) :
+//   Header
+//   tiles  : height rows of rowBytes bytes, two tiles per byte (Dungeon::tileCode, low nibble first)
+//   rooms  : roomCount Rect
+//   exits  : exitCount Rect
+//   spawns : spawnCount LevelSpawn
+class LevelFile
+{
+public:
+	static const uint32_t magic = 0x564C4344; // "DCLV"
+	static const uint32_t version = 1;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t seed;
+		uint16_t width, height;
+		uint32_t rowBytes;
+		uint32_t tilesOffset;
+		uint32_t roomsOffset, roomCount;
+		uint32_t exitsOffset, exitCount;
+		uint32_t spawnsOffset, spawnCount;
+		uint32_t fileSize;
+	};
+
+	LevelFile();
+	~LevelFile();
+
+	LevelFile(const LevelFile&) = delete;
+	LevelFile& operator=(const LevelFile&) = delete;
+
+	// tiles holds Dungeon::tileCode values, the rows are copied as they are packed
+	static bool save(const std::string& path, unsigned int seed, const TileGrid& tiles,
+		const std::vector<Rect>& rooms, const std::vector<Rect>& exits, const std::vector<LevelSpawn>& spawns);
+
+	// maps the file and checks its header, nothing is parsed or copied
+	bool open(const std::string& path);
+	void close();
+
+	const Header& getHeader() const {
+		return *reinterpret_cast<const Header*>(_data);
+	}
+
+	char getTile(int x, int y) const {
+		const Header& header = getHeader();
+		unsigned char pair = _data[header.tilesOffset + y * header.rowBytes + x / 2];
+		return Dungeon::tileFromCode(x % 2 == 0 ? pair & 15 : pair >> 4);
+	}
+
+	const Rect* getRooms() const {
+		return reinterpret_cast<const Rect*>(_data + getHeader().roomsOffset);
+	}
+
+	const Rect* getExits() const {
+		return reinterpret_cast<const Rect*>(_data + getHeader().exitsOffset);
+	}
+
+	const LevelSpawn* getSpawns() const {
+		return reinterpret_cast<const LevelSpawn*>(_data + getHeader().spawnsOffset);
+	}
+
+private:
+	bool isValid() const;
+
+private:
+	const unsigned char* _data;
+	size_t _size;
+
+	// platform handles of the mapping
+	void* _file;
+	void* _mapping;
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// levels, from the most talkative
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_NONE 5
+
+// lowest level compiled in, can be set before including this file or on the command line (/DLOG_LEVEL=0)
+#ifndef LOG_LEVEL
+#ifdef _DEBUG
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+// Prints messages from a background thread, so logging never waits on the console.
+// A message is formatted by the thread that logs it, copied in a slot of a fixed ring buffer and left there.
+// Any thread can log at the same time (the next floor is built on one) : slots are claimed with a compare and swap,
+// nothing is locked and the buffer never grows. When the buffer is full the message is dropped and counted instead.
+// Use the LOG_ macros : below LOG_LEVEL they are empty, the message isn't even formatted.
+class Logger
+{
+public:
+	enum Level
+	{
+		Trace = LOG_LEVEL_TRACE,
+		Debug = LOG_LEVEL_DEBUG,
+		Info = LOG_LEVEL_INFO,
+		Warning = LOG_LEVEL_WARNING,
+		Error = LOG_LEVEL_ERROR
+	};
+
+	static const int capacity = 1024; // slots of the ring buffer, a power of two
+	static const int messageSize = 128; // a longer line is cut
+
+	explicit Logger(std::ostream& out)
+		: _out(out)
+		, _head(0)
+		, _tail(0)
+		, _dropped(0)
+		, _totalDropped(0)
+		, _running(true)
+	{
+		for (size_t i = 0; i < static_cast<size_t>(capacity); i++)
+			_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+		_thread = std::thread(&Logger::drain, this);
+	}
+
+	// prints what is still in the buffer before leaving
+	~Logger()
+	{
+		_running.store(false, std::memory_order_release);
+		_thread.join();
+	}
+
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	// the game's logger, printing to std::cout
+	static Logger& instance()
+	{
+		static Logger logger(std::cout);
+		return logger;
+	}
+
+	// reused by the macros so formatting a message doesn't build a stream each time
+	static std::ostringstream& stream()
+	{
+		thread_local std::ostringstream stream;
+		stream.str(std::string());
+		stream.clear();
+		return stream;
+	}
+
+	// one slot per line of text, false if one had to be dropped
+	bool write(Level level, const std::string& text)
+	{
+		bool written = true;
+		size_t begin = 0;
+		do {
+			size_t end = text.find('\n', begin);
+			if (end == std::string::npos)
+				end = text.size();
+			written &= push(level, text.data() + begin, end - begin);
+			begin = end + 1;
+		} while (begin < text.size());
+
+		return written;
+	}
+
+	// messages lost because the buffer was full, since the start
+	long long getDroppedCount() const
+	{
+		return _totalDropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence; // position the slot is free for, or that position + 1 once written
+		Level level;
+		char text[messageSize];
+	};
+
+	bool push(Level level, const char* text, size_t length)
+	{
+		size_t position = _head.load(std::memory_order_relaxed);
+		Slot* slot;
+		for (;;) {
+			slot = &_slots[position & (capacity - 1)];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+			if (difference == 0) {
+				if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0) {
+				// the drain thread hasn't freed this slot yet : full
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+				_totalDropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else {
+				// another thread took it first
+				position = _head.load(std::memory_order_relaxed);
+			}
+		}
+
+		if (length > static_cast<size_t>(messageSize - 1))
+			length = messageSize - 1;
+		std::memcpy(slot->text, text, length);
+		slot->text[length] = '\0';
+		slot->level = level;
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// background thread : prints every written slot in order, then sleeps a little when there is none
+	void drain()
+	{
+		static const char* tags[] = { "[trace] ", "[debug] ", "[info] ", "[warning] ", "[error] " };
+		std::string lines;
+
+		for (;;) {
+			bool running = _running.load(std::memory_order_acquire);
+
+			lines.clear();
+			for (;;) {
+				Slot& slot = _slots[_tail & (capacity - 1)];
+				if (slot.sequence.load(std::memory_order_acquire) != _tail + 1)
+					break;
+
+				lines += tags[slot.level];
+				lines += slot.text;
+				lines += '\n';
+				slot.sequence.store(_tail + capacity, std::memory_order_release);
+				++_tail;
+			}
+
+			long long dropped = _dropped.exchange(0, std::memory_order_relaxed);
+			if (dropped > 0)
+				lines += "[log] " + std::to_string(dropped) + " messages dropped\n";
+
+			if (!lines.empty()) {
+				_out << lines;
+				_out.flush();
+			}
+			else if (!running) {
+				return;
+			}
+			else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+	}
+
+private:
+	std::ostream& _out;
+	Slot _slots[capacity];
+	std::atomic<size_t> _head; // next position to write
+	size_t _tail; // next position to print, only the drain thread touches it
+	std::atomic<long long> _dropped; // since the last print
+	std::atomic<long long> _totalDropped;
+	std::atomic<bool> _running;
+	std::thread _thread;
+};
+
+#define LOG_AT(level, message) \
+	do { \
+		std::ostringstream& logStream = Logger::stream(); \
+		logStream << message; \
+		Logger::instance().write(level, logStream.str()); \
+	} while (false)
+
+#if LOG_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(message) LOG_AT(Logger::Trace, message)
+#else
+#define LOG_TRACE(message) do {} while (false)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(message) LOG_AT(Logger::Debug, message)
+#else
+#define LOG_DEBUG(message) do {} while (false)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(message) LOG_AT(Logger::Info, message)
+#else
+#define LOG_INFO(message) do {} while (false)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(message) LOG_AT(Logger::Warning, message)
+#else
+#define LOG_WARNING(message) do {} while (false)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(message) LOG_AT(Logger::Error, message)
+#else
+#define LOG_ERROR(message) do {} while (false)
+#endif
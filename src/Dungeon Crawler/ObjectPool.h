@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Owns every object of one type for a level : objects are constructed one after the other in big blocks
+// (a bump of the block's count, no heap allocation per object), stay at the same address until the pool goes,
+// and are all destroyed together with the pool. Nothing is freed one by one, so it only suits objects that live as long as it.
+template <typename T>
+class ObjectPool
+{
+public:
+	explicit ObjectPool(int blockSize = 256)
+		: _blockSize(blockSize)
+		, _size(0)
+		, _blocks()
+	{
+	}
+
+	~ObjectPool()
+	{
+		clear();
+	}
+
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	// the next count objects go in the same block, when the count is known beforehand
+	void reserve(int count)
+	{
+		if (_blocks.empty() || _blocks.back().capacity - _blocks.back().count < count)
+			addBlock(count);
+	}
+
+	template <typename... Args>
+	T* create(Args&&... args)
+	{
+		// the blocks grow with the pool so a big level ends up in a few blocks
+		if (_blocks.empty() || _blocks.back().count == _blocks.back().capacity)
+			addBlock(std::max(_blockSize, _size));
+
+		Block& block = _blocks.back();
+		T* object = new (&block.storage[block.count]) T(std::forward<Args>(args)...);
+		++block.count;
+		++_size;
+		return object;
+	}
+
+	int size() const
+	{
+		return _size;
+	}
+
+	int getBlockCount() const
+	{
+		return static_cast<int>(_blocks.size());
+	}
+
+	// destroys every object, the last created first, and gives the blocks back
+	void clear()
+	{
+		for (auto block = _blocks.rbegin(); block != _blocks.rend(); ++block)
+			for (int i = block->count - 1; i >= 0; --i)
+				reinterpret_cast<T*>(&block->storage[i])->~T();
+
+		_blocks.clear();
+		_size = 0;
+	}
+
+private:
+	typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+	struct Block
+	{
+		std::unique_ptr<Slot[]> storage;
+		int capacity;
+		int count;
+	};
+
+	void addBlock(int capacity)
+	{
+		_blocks.push_back(Block{ std::unique_ptr<Slot[]>(new Slot[capacity]), capacity, 0 });
+	}
+
+private:
+	int _blockSize;
+	int _size;
+	std::vector<Block> _blocks;
+};
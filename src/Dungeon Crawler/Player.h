@@ -1,12 +1,7 @@
 #pragma once
 
 #include <iostream>
-#include <SFML\Graphics.hpp>
-#include "Coin.h"
-#include "Enemy.h"
-#include "Ground.h"
-#include "EmptySpace.h"
-#include "Stairs.h"
+#include <SFML/Graphics.hpp>
 
 
 class Player
@@ -22,6 +17,11 @@ public:
 		window.draw(player);
 	}
 
+	// for a texture that was still loading when the player was made
+	void setTexture(sf::Texture* texture) {
+		player.setTexture(texture, true);
+	}
+
 	void move(sf::Vector2f distance) {
 		player.move(distance);
 	}
@@ -44,26 +44,15 @@ public:
 		return player.getPosition().x;
 	}
 
-	bool isCollidingWithCoin(Coin *coin) {
-		if (player.getGlobalBounds().intersects(coin->getGlobalBounds())) {
-			return true;
-		}
-		return false;
-	}
-	bool isCollidingWithEnemy(Enemy* enemy) {
-		if (player.getGlobalBounds().intersects(enemy->getGlobalBounds())) {
-			return true;
-		}
-		return false;
-	}
-	bool isCollidingWithGround(Ground* ground) {
-		if (player.getGlobalBounds().intersects(ground->getGlobalBounds())) {
+	// walls and stairs are only their box (see Level)
+	bool isCollidingWithWall(const sf::FloatRect& wall) {
+		if (player.getGlobalBounds().intersects(wall)) {
 			return true;
 		}
 		return false;
 	}
-	bool isCollidingWithStairs(Stairs stairs) {
-		if (player.getGlobalBounds().intersects(stairs.getGlobalBounds())) {
+	bool isCollidingWithStairs(const sf::FloatRect& stairs) {
+		if (player.getGlobalBounds().intersects(stairs)) {
 			return true;
 		}
 		return false;
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// set to 0 (/DPROFILER_ENABLED=0) to compile the PROFILE_ macros out
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Where the time of a frame goes : zones are timed with a scoped object and counters add up over the frame.
+// Every frame keeps its length for the percentiles and a smoothed time per zone for the overlay (see getSummary).
+// Once record() is called, every zone of every frame is also kept to be written as a trace, up to maxEvents.
+// Only the game thread profiles, nothing here is locked. Use the PROFILE_ macros so it all disappears when compiled out.
+class Profiler
+{
+public:
+	static const int historySize = 240; // frames the percentiles are taken from
+	static const int maxEvents = 1 << 18; // zones and counters kept for the trace, the later ones are not recorded
+
+	typedef std::chrono::steady_clock Clock;
+
+	// times the scope it lives in
+	class Zone
+	{
+	public:
+		explicit Zone(const char* name)
+			: _name(name)
+			, _start(Clock::now())
+		{
+		}
+
+		~Zone()
+		{
+			instance().addZone(_name, _start, Clock::now());
+		}
+
+	private:
+		const char* _name;
+		Clock::time_point _start;
+	};
+
+	Profiler()
+		: _start(Clock::now())
+		, _frameStart(_start)
+		, _frame(0)
+		, _frameCount(0)
+		, _recording(false)
+	{
+		std::fill(_frameTimes, _frameTimes + historySize, 0.f);
+	}
+
+	static Profiler& instance()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	// keeps every zone and counter from now on, for writeTrace and writeCsv
+	void record()
+	{
+		_recording = true;
+		_events.reserve(maxEvents);
+	}
+
+	// ends the frame being measured and starts the next one
+	void beginFrame()
+	{
+		Clock::time_point now = Clock::now();
+		if (_frame > 0) {
+			_frameTimes[(_frame - 1) % historySize] = milliseconds(_frameStart, now);
+			if (_frameCount < historySize)
+				++_frameCount;
+			addEvent("frame", _frameStart, now, -1);
+
+			for (Stat& stat : _zones) {
+				stat.average += (stat.current - stat.average) * 0.1;
+				stat.current = 0.0;
+			}
+			for (Stat& stat : _counters) {
+				addEvent(stat.name, now, now, static_cast<long long>(stat.current));
+				stat.average = stat.current;
+				stat.current = 0.0;
+			}
+		}
+
+		_frameStart = now;
+		++_frame;
+	}
+
+	void count(const char* name, long long amount)
+	{
+		find(_counters, name).current += static_cast<double>(amount);
+	}
+
+	// frame length below which p percents of the last frames are, in milliseconds
+	float getFramePercentile(float p) const
+	{
+		if (_frameCount == 0)
+			return 0.f;
+
+		std::vector<float> times(_frameTimes, _frameTimes + _frameCount);
+		size_t rank = std::min(times.size() - 1, static_cast<size_t>(p / 100.f * times.size()));
+		std::nth_element(times.begin(), times.begin() + rank, times.end());
+		return times[rank];
+	}
+
+	// the text of the overlay : frame percentiles, then the smoothed time of each zone and last frame's counters
+	std::string getSummary() const
+	{
+		std::ostringstream text;
+		text.precision(2);
+		text << std::fixed << "frame p50 " << getFramePercentile(50.f) << " ms  p95 " << getFramePercentile(95.f)
+			<< " ms  p99 " << getFramePercentile(99.f) << " ms\n";
+		for (const Stat& stat : _zones)
+			text << stat.name << " " << stat.average << " ms\n";
+		text.precision(0);
+		for (const Stat& stat : _counters)
+			text << stat.name << " " << stat.average << "\n";
+
+		return text.str();
+	}
+
+	// the recorded events in the trace event format, for chrome://tracing or Perfetto
+	bool writeTrace(const std::string& path) const
+	{
+		std::ofstream out(path);
+		out << "{\"traceEvents\":[";
+		for (size_t i = 0; i < _events.size(); i++) {
+			const Event& event = _events[i];
+			out << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":1,\"ts\":" << event.start;
+			if (event.counter)
+				out << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+			else
+				out << ",\"ph\":\"X\",\"dur\":" << event.duration << "}";
+		}
+		out << "\n]}\n";
+
+		return static_cast<bool>(out);
+	}
+
+	// one line per recorded event, times in microseconds from the start
+	bool writeCsv(const std::string& path) const
+	{
+		std::ofstream out(path);
+		out << "frame,name,start_us,duration_us,value\n";
+		for (const Event& event : _events) {
+			out << event.frame << "," << event.name << "," << event.start << ",";
+			if (event.counter)
+				out << "," << event.value << "\n";
+			else
+				out << event.duration << ",\n";
+		}
+
+		return static_cast<bool>(out);
+	}
+
+private:
+	struct Stat
+	{
+		const char* name;
+		double current; // this frame, milliseconds for a zone
+		double average; // smoothed for a zone, last frame for a counter
+	};
+
+	struct Event
+	{
+		const char* name;
+		int frame;
+		bool counter;
+		long long start; // microseconds from the start
+		long long duration;
+		long long value;
+	};
+
+	// names are string literals, a zone or a counter is only looked for among a dozen others
+	static Stat& find(std::vector<Stat>& stats, const char* name)
+	{
+		for (Stat& stat : stats)
+			if (stat.name == name || std::strcmp(stat.name, name) == 0)
+				return stat;
+
+		stats.push_back(Stat{ name, 0.0, 0.0 });
+		return stats.back();
+	}
+
+	static float milliseconds(Clock::time_point from, Clock::time_point to)
+	{
+		return std::chrono::duration<float, std::milli>(to - from).count();
+	}
+
+	long long microseconds(Clock::time_point time) const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(time - _start).count();
+	}
+
+	void addZone(const char* name, Clock::time_point start, Clock::time_point end)
+	{
+		find(_zones, name).current += milliseconds(start, end);
+		addEvent(name, start, end, -1);
+	}
+
+	// value is -1 for a zone
+	void addEvent(const char* name, Clock::time_point start, Clock::time_point end, long long value)
+	{
+		if (!_recording || _events.size() >= static_cast<size_t>(maxEvents))
+			return;
+
+		_events.push_back(Event{ name, _frame, value >= 0, microseconds(start), microseconds(end) - microseconds(start), value });
+	}
+
+private:
+	Clock::time_point _start;
+	Clock::time_point _frameStart;
+	int _frame; // frames begun
+	int _frameCount; // frame times in _frameTimes
+	float _frameTimes[historySize]; // milliseconds, a ring over the last frames
+	std::vector<Stat> _zones;
+	std::vector<Stat> _counters;
+	bool _recording;
+	std::vector<Event> _events;
+};
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_COUNT(name, amount) Profiler::instance().count(name, amount)
+#define PROFILE_FRAME() Profiler::instance().beginFrame()
+#else
+#define PROFILE_ZONE(name) do {} while (false)
+#define PROFILE_COUNT(name, amount) do {} while (false)
+#define PROFILE_FRAME() do {} while (false)
+#endif
@@ -1,39 +1,393 @@
 #ifndef __QUADTREE_H__
 #define __QUADTREE_H__
 
+#include <algorithm>
+#include <sstream>
 #include <vector>
-#include "Ground.h"
+#include <SFML/Graphics.hpp>
 
 using namespace std;
 
+// how a QuadTree gets the box of what it stores when insert isn't given one : object->getGlobalBounds()
+template <typename T>
+struct QuadTreeBounds
+{
+	static sf::FloatRect get(const T& object)
+	{
+		return object->getGlobalBounds();
+	}
+};
+
+// a box is its own bounds, walls are stored as the box of their tile
+template <>
+struct QuadTreeBounds<sf::FloatRect>
+{
+	static sf::FloatRect get(const sf::FloatRect& box)
+	{
+		return box;
+	}
+};
+
+// A node only splits in four once it holds more than capacity objects, and never deeper than maxDepth.
+// The tree is loose : an object goes to the child its center is in, and a child reaches half its size past its borders,
+// so an object lying across a split line still goes down as long as it is no bigger than the child.
+// Every node keeps the box around all it holds, children included : a query only goes down the children whose box
+// the range overlaps and only gives the objects the range overlaps.
+// Where an object goes only depends on its box, so remove and update find it again from the box it was stored with.
+// A node whose children hold no more than half its capacity between them takes their objects back and drops them.
+// T is anything cheap to copy and to compare, walls are stored as their sf::FloatRect, coins and enemies as an EntityHandle with their box.
+template <typename T, typename Bounds = QuadTreeBounds<T>>
 class QuadTree
 {
 public:
-	QuadTree(sf::FloatRect boundary, int level);
-	~QuadTree();
+	static const int defaultCapacity = 8;
+	static const int defaultMaxDepth = 10;
+
+	QuadTree(sf::FloatRect _boundary, int _level, int _capacity = defaultCapacity, int _maxDepth = defaultMaxDepth) :
+		level(_level),
+		capacity(_capacity),
+		maxDepth(_maxDepth),
+		boundary(_boundary),
+		contentBounds(_boundary),
+		count(0)
+	{
+		// the subsections are only created when the node gets too full
+		for (QuadTree*& child : children) {
+			child = nullptr;
+		}
+	}
+
+	~QuadTree()
+	{
+		clear();
+	}
+
+	QuadTree(const QuadTree&) = delete;
+	QuadTree& operator=(const QuadTree&) = delete;
+
+	void insert(T object) {
+
+		insert(Entry{ object, Bounds::get(object) });
+	}
+
+	// for objects that don't know their box, or that have it elsewhere
+	void insert(T object, sf::FloatRect bounds) {
+
+		insert(Entry{ object, bounds });
+	}
+
+	// removes every object and every subsection, the boundary stays
+	void clear() {
+
+		// deleting every subsections
+		for (QuadTree*& child : children) {
+			delete child;
+			child = nullptr;
+		}
+		objects.clear();
+		count = 0;
+	}
+
+	// takes the object out, bounds being the box it was inserted or last updated with. False if it isn't there.
+	bool remove(const T& object, const sf::FloatRect& bounds) {
+
+		if (children[0] != nullptr) {
+			QuadTree* child = childFor(bounds);
+			if (child != nullptr) {
+				if (!child->remove(object, bounds)) {
+					return false;
+				}
+				--count;
+				if (count <= capacity / 2) {
+					merge();
+				}
+				return true;
+			}
+		}
+
+		Entry* entry = find(object);
+		if (entry == nullptr) {
+			return false;
+		}
+		*entry = objects.back();
+		objects.pop_back();
+		--count;
+		return true;
+	}
+
+	// moves the object stored with oldBounds to newBounds. It only changes node when newBounds doesn't fit the one
+	// it is in anymore, otherwise its box is changed where it is. False if it isn't there.
+	bool update(const T& object, const sf::FloatRect& oldBounds, const sf::FloatRect& newBounds) {
+
+		QuadTree* from = children[0] != nullptr ? childFor(oldBounds) : nullptr;
+		QuadTree* to = children[0] != nullptr ? childFor(newBounds) : nullptr;
+
+		// both boxes go the same way : this node keeps holding the object
+		if (from == to) {
+			if (from != nullptr) {
+				if (!from->update(object, oldBounds, newBounds)) {
+					return false;
+				}
+				include(newBounds);
+				return true;
+			}
+
+			Entry* entry = find(object);
+			if (entry == nullptr) {
+				return false;
+			}
+			entry->bounds = newBounds;
+			include(newBounds);
+			return true;
+		}
+
+		// the ways part here, the object leaves one child (or this node) for another
+		if (from != nullptr) {
+			if (!from->remove(object, oldBounds)) {
+				return false;
+			}
+		}
+		else {
+			Entry* entry = find(object);
+			if (entry == nullptr) {
+				return false;
+			}
+			*entry = objects.back();
+			objects.pop_back();
+		}
+
+		if (to != nullptr) {
+			to->insert(Entry{ object, newBounds });
+		}
+		else {
+			objects.push_back(Entry{ object, newBounds });
+		}
+		include(newBounds);
+		return true;
+	}
+
+	// objects in the node and its children
+	int getCount() const {
+
+		return count;
+	}
+
+	vector<T> getObjects(sf::FloatRect range) const {
+
+		vector<T> objectsInRange;
+		getObjects(range, objectsInRange);
+		return objectsInRange;
+	}
+
+	// same objects into a buffer kept by the caller, cleared first : once it is big enough a query allocates nothing
+	void getObjects(sf::FloatRect range, vector<T>& result) const {
+
+		result.clear();
+		forEachObject(range, [&result](const T& object) { result.push_back(object); });
+	}
+
+	// calls visit(object) for every object getObjects would return, without copying them anywhere
+	template <typename Visit>
+	void forEachObject(sf::FloatRect range, Visit&& visit) const
+	{
+		for (const Entry& entry : objects)
+			if (overlaps(entry.bounds, range))
+				visit(entry.object);
+
+		if (children[0] == nullptr)
+			return;
+
+		for (const QuadTree* child : children)
+			if (child->count > 0 && overlaps(child->contentBounds, range))
+				child->forEachObject(range, visit);
+	}
 
-	void insert(Ground* object);
-	vector<Ground*> getObjects(sf::FloatRect range);
-	void Draw(sf::RenderTarget& canvas);
+	// nodes created so far, this one included
+	int getNodeCount() const {
+
+		int count = 1;
+		if (children[0] != nullptr) {
+			for (const QuadTree* child : children) {
+				count += child->getNodeCount();
+			}
+		}
+		return count;
+	}
+
+	void Draw(sf::RenderTarget& canvas) const {
+
+		sf::RectangleShape shape(sf::Vector2f(boundary.width, boundary.height));
+		shape.setPosition(boundary.left, boundary.top);
+		shape.setFillColor(sf::Color(0, 0, 0, 0));
+		shape.setOutlineThickness(1.0f);
+		shape.setOutlineColor(sf::Color(64, 128, 255));
+
+		stringstream ss;
+		ss << objects.size();
+		sf::Text text;
+		text.setString(ss.str());
+		text.setPosition(boundary.left, boundary.top + level * 16);
+		text.setCharacterSize(12);
+
+		canvas.draw(shape);
+		canvas.draw(text);
+
+		if (children[0] != nullptr) {
+			for (const QuadTree* child : children) {
+				child->Draw(canvas);
+			}
+		}
+	}
 
 private :
-	bool contains(QuadTree* child, Ground* object);
+	struct Entry
+	{
+		T object;
+		sf::FloatRect bounds; // taken once at insert
+	};
+
+	void insert(const Entry& entry) {
+
+		include(entry.bounds);
+		++count;
+
+		// go down while a child can hold the object
+		if (children[0] != nullptr) {
+			QuadTree* child = childFor(entry.bounds);
+			if (child != nullptr) {
+				child->insert(entry);
+				return;
+			}
+		}
+
+		objects.push_back(entry);
+
+		if (children[0] == nullptr && static_cast<int>(objects.size()) > capacity && level < maxDepth) {
+			split();
+		}
+	}
+
+	// the objects are handed down again, the ones no child can hold stay here
+	void split() {
+
+		const float width = boundary.width / 2.0f, height = boundary.height / 2.0f;
+		children[0] = new QuadTree(sf::FloatRect(boundary.left, boundary.top, width, height), level + 1, capacity, maxDepth);
+		children[1] = new QuadTree(sf::FloatRect(boundary.left + width, boundary.top, width, height), level + 1, capacity, maxDepth);
+		children[2] = new QuadTree(sf::FloatRect(boundary.left, boundary.top + height, width, height), level + 1, capacity, maxDepth);
+		children[3] = new QuadTree(sf::FloatRect(boundary.left + width, boundary.top + height, width, height), level + 1, capacity, maxDepth);
+
+		vector<Entry> entries;
+		entries.swap(objects);
+		for (const Entry& entry : entries) {
+			QuadTree* child = childFor(entry.bounds);
+			if (child != nullptr) {
+				child->insert(entry);
+			}
+			else {
+				objects.push_back(entry);
+			}
+		}
+	}
+
+	// the objects of the children come back here and the children are dropped, the box fits the objects again
+	void merge() {
+
+		if (children[0] == nullptr) {
+			return;
+		}
+
+		for (QuadTree*& child : children) {
+			child->gather(objects);
+			delete child;
+			child = nullptr;
+		}
+
+		if (!objects.empty()) {
+			contentBounds = objects[0].bounds;
+			for (const Entry& entry : objects) {
+				include(entry.bounds);
+			}
+		}
+	}
+
+	// appends every object of the node and its children
+	void gather(vector<Entry>& entries) const {
+
+		entries.insert(entries.end(), objects.begin(), objects.end());
+		if (children[0] != nullptr) {
+			for (const QuadTree* child : children) {
+				child->gather(entries);
+			}
+		}
+	}
+
+	// grows the box around the content to hold bounds too
+	void include(const sf::FloatRect& bounds) {
+
+		if (count == 0) {
+			contentBounds = bounds;
+			return;
+		}
+
+		const float right = max(contentBounds.left + contentBounds.width, bounds.left + bounds.width);
+		const float bottom = max(contentBounds.top + contentBounds.height, bounds.top + bounds.height);
+		contentBounds.left = min(contentBounds.left, bounds.left);
+		contentBounds.top = min(contentBounds.top, bounds.top);
+		contentBounds.width = right - contentBounds.left;
+		contentBounds.height = bottom - contentBounds.top;
+	}
+
+	// the object among the ones of this node only, null if it isn't there
+	Entry* find(const T& object) {
+
+		for (Entry& entry : objects) {
+			if (entry.object == object) {
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+	// the child the center of the box is in, if its loose bounds hold the whole box
+	QuadTree* childFor(const sf::FloatRect& bounds) const {
+
+		const float centerX = bounds.left + bounds.width / 2.0f, centerY = bounds.top + bounds.height / 2.0f;
+		const bool east = centerX >= boundary.left + boundary.width / 2.0f;
+		const bool south = centerY >= boundary.top + boundary.height / 2.0f;
+		QuadTree* child = children[(south ? 2 : 0) + (east ? 1 : 0)];
+
+		const sf::FloatRect loose = child->looseBoundary();
+		bool fits = (bounds.left >= loose.left &&
+					bounds.top >= loose.top &&
+					bounds.left + bounds.width <= loose.left + loose.width &&
+					bounds.top + bounds.height <= loose.top + loose.height);
+
+		return fits ? child : nullptr;
+	}
+
+	// the boundary grown by half its size on every side
+	sf::FloatRect looseBoundary() const {
+
+		return sf::FloatRect(boundary.left - boundary.width / 2.0f, boundary.top - boundary.height / 2.0f, boundary.width * 2.0f, boundary.height * 2.0f);
+	}
+
+	// same as sf::FloatRect::intersects for boxes of positive size, without sorting the corners first
+	static bool overlaps(const sf::FloatRect& a, const sf::FloatRect& b)
+	{
+		return a.left < b.left + b.width && b.left < a.left + a.width && a.top < b.top + b.height && b.top < a.top + a.height;
+	}
 
 private:
-	const int maxLevel = 3;
 	int level;
+	int capacity;
+	int maxDepth;
 	sf::FloatRect boundary;
-	vector<Ground*>	objects;
-
-	// To Draw the quadtree
-	sf::RectangleShape shape;
-	sf::Text text;
+	sf::FloatRect contentBounds; // around every object of the node and its children, only grows until the next merge
+	int count; // objects in the node and its children
+	vector<Entry> objects;
 
-	// QuadTree contains 4 children
-	QuadTree* northWest;
-	QuadTree* northEast;
-	QuadTree* southWest;
-	QuadTree* southEast;
+	// north west, north east, south west, south east, all null until the node splits
+	QuadTree* children[4];
 };
 
 #endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <random>
+
+// seedable random engine, every generator owns its own so the same seed always gives the same result
+class Random
+{
+public:
+	explicit Random(unsigned int seed)
+		: _seed(seed)
+		, _mt(seed)
+	{
+	}
+
+	int randomInt(int exclusiveMax)
+	{
+		std::uniform_int_distribution<> dist(0, exclusiveMax - 1);
+		return dist(_mt);
+	}
+
+	int randomInt(int min, int max) // inclusive min/max
+	{
+		std::uniform_int_distribution<> dist(0, max - min);
+		return dist(_mt) + min;
+	}
+
+	bool randomBool(double probability = 0.5)
+	{
+		std::bernoulli_distribution dist(probability);
+		return dist(_mt);
+	}
+
+	unsigned int getSeed() const
+	{
+		return _seed;
+	}
+
+	// seed to use when nothing has to be reproduced
+	static unsigned int randomSeed()
+	{
+		std::random_device rd;
+		return rd();
+	}
+
+private:
+	unsigned int _seed;
+	std::mt19937 _mt;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <SFML/Graphics.hpp>
+#include "Logger.h"
+
+// Loads every file once and keeps it for the whole game. get() hands out the same object for the same file,
+// whatever case the path is written in (Windows doesn't care, "Minecraft.ttf" and "minecraft.ttf" are one file),
+// and the object never moves, so the pointer can be kept. A file that fails to load gives an empty resource.
+// A file decoded elsewhere (see AssetLoader) is reserved first, so its pointer can be handed out, then filled by load().
+template <typename Resource>
+class ResourceCache
+{
+public:
+	// the file's resource, loaded from the disk right now the first time
+	Resource* get(const std::string& path)
+	{
+		auto it = _entries.find(key(path));
+		if (it != _entries.end())
+			return it->second.resource.get();
+
+		return load(path, [&path](Resource& resource) { return resource.loadFromFile(path); });
+	}
+
+	// the file's resource, left empty until load() is called for it
+	Resource* reserve(const std::string& path)
+	{
+		Entry& entry = _entries[key(path)];
+		if (!entry.resource) {
+			entry.path = path;
+			entry.resource.reset(new Resource());
+		}
+
+		return entry.resource.get();
+	}
+
+	// fills the file's resource with load(resource), which returns false on failure.
+	// source is kept as long as the resource, for the ones that keep reading from memory (sf::Font::loadFromMemory),
+	// sourceBytes is its size. decodeSeconds is the time the file already took to be read and decoded elsewhere.
+	template <typename Load>
+	Resource* load(const std::string& path, Load load, std::shared_ptr<const void> source = nullptr, size_t sourceBytes = 0, double decodeSeconds = 0.0)
+	{
+		Resource* resource = reserve(path);
+		Entry& entry = _entries[key(path)];
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		entry.loaded = load(*resource);
+		entry.loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		entry.decodeSeconds = decodeSeconds;
+		entry.bytes = entry.loaded ? memorySize(*resource, sourceBytes) : 0;
+		entry.source = source;
+
+		if (!entry.loaded)
+			LOG_ERROR("Load failed : " << path);
+
+		return resource;
+	}
+
+	// false if a file could not be loaded or is still reserved
+	bool allLoaded() const
+	{
+		for (const auto& entry : _entries)
+			if (!entry.second.loaded)
+				return false;
+		return true;
+	}
+
+	int size() const
+	{
+		return static_cast<int>(_entries.size());
+	}
+
+	// one line per file : load time, decoding included, and memory
+	void report(std::ostream& out) const
+	{
+		for (const auto& entry : _entries)
+			out << entry.second.path << " : " << (entry.second.loaded ? "" : "FAILED, ")
+				<< (entry.second.decodeSeconds + entry.second.loadSeconds) * 1000.0 << " ms (" << entry.second.decodeSeconds * 1000.0
+				<< " ms decoding), " << entry.second.bytes / 1024 << " KB" << std::endl;
+	}
+
+private:
+	struct Entry
+	{
+		std::string path; // as first asked for
+		std::unique_ptr<Resource> resource;
+		std::shared_ptr<const void> source;
+		bool loaded = false;
+		double decodeSeconds = 0.0; // before load(), on another thread
+		double loadSeconds = 0.0;
+		size_t bytes = 0;
+	};
+
+	static std::string key(const std::string& path)
+	{
+		std::string lower = path;
+		std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return lower;
+	}
+
+	// pixels of a texture, 4 bytes each
+	static size_t memorySize(const sf::Texture& texture, size_t)
+	{
+		return static_cast<size_t>(texture.getSize().x) * texture.getSize().y * 4;
+	}
+
+	// a font reads its glyphs from the file kept in memory, so the file is what it costs.
+	// One loaded by get() is read from the disk as needed and has no source
+	static size_t memorySize(const sf::Font&, size_t sourceBytes)
+	{
+		return sourceBytes;
+	}
+
+private:
+	std::unordered_map<std::string, Entry> _entries; // by lower case path
+};
+
+// every texture and font of the game
+struct Resources
+{
+	ResourceCache<sf::Texture> textures;
+	ResourceCache<sf::Font> fonts;
+
+	void report(std::ostream& out) const
+	{
+		textures.report(out);
+		fonts.report(out);
+	}
+};
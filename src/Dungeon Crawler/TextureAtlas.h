@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "Logger.h"
+
+// Every image of the game side by side in one texture, so a whole layer of tiles can be drawn with a single bind.
+class TextureAtlas
+{
+public:
+	enum Frame
+	{
+		Wall,
+		Coin,
+		Slime,
+		Stairs,
+		Chara,
+		FrameCount
+	};
+
+	TextureAtlas()
+	{
+		for (sf::IntRect& rect : _rects)
+			rect = sf::IntRect(0, 0, 0, 0);
+	}
+
+	// file of the frame's image
+	static std::string getPath(Frame frame, const std::string& directory = "res/img/")
+	{
+		static const char* files[FrameCount] = { "wall.png", "coin.png", "slime.jpg", "stairs.png", "chara.png" };
+		return directory + files[frame];
+	}
+
+	// loads the images of res/img and packs them, false if one of them is missing
+	bool loadFromFiles(const std::string& directory = "res/img/")
+	{
+		sf::Image images[FrameCount];
+		for (int i = 0; i < FrameCount; i++) {
+			if (!images[i].loadFromFile(getPath(static_cast<Frame>(i), directory))) {
+				LOG_ERROR("Load failed : " << getPath(static_cast<Frame>(i), directory));
+				return false;
+			}
+		}
+
+		return pack(images);
+	}
+
+	// one row, left to right in Frame order, with a transparent pixel between two images so they don't bleed on each other
+	bool pack(const sf::Image (&images)[FrameCount])
+	{
+		unsigned int width = 0, height = 0;
+		for (const sf::Image& image : images) {
+			width += image.getSize().x + 1;
+			height = std::max(height, image.getSize().y);
+		}
+
+		sf::Image atlas;
+		atlas.create(width, height, sf::Color::Transparent);
+
+		unsigned int left = 0;
+		for (int i = 0; i < FrameCount; i++) {
+			atlas.copy(images[i], left, 0);
+			_rects[i] = sf::IntRect(left, 0, images[i].getSize().x, images[i].getSize().y);
+			left += images[i].getSize().x + 1;
+		}
+
+		return _texture.loadFromImage(atlas);
+	}
+
+	const sf::Texture& getTexture() const
+	{
+		return _texture;
+	}
+
+	// where the image is in the texture, in pixels
+	sf::IntRect getRect(Frame frame) const
+	{
+		return _rects[frame];
+	}
+
+private:
+	sf::Texture _texture;
+	sf::IntRect _rects[FrameCount];
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Grid of 4 bit codes, 16 per 64 bit word (first tile in the low nibble), every row padded to whole words.
+// The padding nibbles are always 0, so rows can be scanned or compared a word at a time.
+class TileGrid
+{
+public:
+	static const int tilesPerWord = 16;
+
+	TileGrid()
+		: _width(0)
+		, _height(0)
+		, _rowWords(0)
+		, _words()
+	{
+	}
+
+	TileGrid(int width, int height, int code = 0)
+		: _width(width)
+		, _height(height)
+		, _rowWords((width + tilesPerWord - 1) / tilesPerWord)
+		, _words(_rowWords* height, 0)
+	{
+		if (code != 0)
+			for (int y = 0; y < height; ++y)
+				for (int w = 0; w < _rowWords; ++w)
+					_words[w + y * _rowWords] = (code & 15) * lowNibbles() & validMask(w);
+	}
+
+	int get(int x, int y) const
+	{
+		return (_words[(x >> 4) + y * _rowWords] >> ((x & 15) * 4)) & 15;
+	}
+
+	void set(int x, int y, int code)
+	{
+		uint64_t& word = _words[(x >> 4) + y * _rowWords];
+		int shift = (x & 15) * 4;
+		word = (word & ~(uint64_t(15) << shift)) | (uint64_t(code & 15) << shift);
+	}
+
+	int getWidth() const
+	{
+		return _width;
+	}
+
+	int getHeight() const
+	{
+		return _height;
+	}
+
+	int getRowWords() const
+	{
+		return _rowWords;
+	}
+
+	const uint64_t* row(int y) const
+	{
+		return &_words[y * _rowWords];
+	}
+
+	uint64_t* row(int y)
+	{
+		return &_words[y * _rowWords];
+	}
+
+	// tiles of the word w of a row that are inside the grid, the others are padding
+	uint64_t validMask(int w) const
+	{
+		int count = _width - w * tilesPerWord;
+		return count >= tilesPerWord ? ~uint64_t(0) : (uint64_t(1) << (count * 4)) - 1;
+	}
+
+	// number of tiles with the given code, a word at a time
+	int count(int code) const
+	{
+		int total = 0;
+		for (int y = 0; y < _height; ++y)
+			for (int w = 0; w < _rowWords; ++w)
+				total += bitCount(lanesEqual(_words[w + y * _rowWords], code) & validMask(w));
+
+		return total;
+	}
+
+	size_t getMemorySize() const
+	{
+		return _words.size() * sizeof(uint64_t);
+	}
+
+	bool operator==(const TileGrid& other) const
+	{
+		return _width == other._width && _height == other._height && _words == other._words;
+	}
+
+	bool operator!=(const TileGrid& other) const
+	{
+		return !(*this == other);
+	}
+
+	// 0x1 in the low bit of every nibble
+	static uint64_t lowNibbles()
+	{
+		return 0x1111111111111111ull;
+	}
+
+	// low bit of every nibble of the word that holds code, the others are 0
+	static uint64_t lanesEqual(uint64_t word, int code)
+	{
+		uint64_t x = word ^ ((code & 15) * lowNibbles());
+		return ~(x | x >> 1 | x >> 2 | x >> 3) & lowNibbles();
+	}
+
+	static int bitCount(uint64_t x)
+	{
+		x = x - ((x >> 1) & 0x5555555555555555ull);
+		x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+		x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<int>((x * 0x0101010101010101ull) >> 56);
+	}
+
+private:
+	int _width, _height;
+	int _rowWords;
+	std::vector<uint64_t> _words;
+};
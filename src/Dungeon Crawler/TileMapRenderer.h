@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "EntityStore.h"
+#include "TextureAtlas.h"
+
+// Draws a floor in one call per layer : every tile of a layer is a quad of the same vertex array, textured from the atlas.
+// The static layer (walls and stairs) is only built when the floor changes, cut in square pages of pageTiles tiles.
+// A page is rendered once into its own texture the first time it shows, then every frame draws one quad per page in view.
+// Pickups and actors are refilled every frame with only the entities in view, found through the quadtrees of the entity store.
+class TileMapRenderer
+{
+public:
+	static const int pageTiles = 16; // tiles per side of a page of the static layer
+	static const int maxPageTextures = 32; // rendered pages kept, the ones shown the longest ago are dropped past it
+
+	enum Layer
+	{
+		StaticLayer,
+		PickupLayer,
+		ActorLayer,
+		LayerCount
+	};
+
+	explicit TileMapRenderer(const TextureAtlas& atlas)
+		: _atlas(atlas)
+		, _tileSize(1.f)
+		, _staticQuads(0)
+		, _pageTextures(0)
+		, _frame(0)
+		, _pickups(sf::Quads)
+		, _actors(sf::Quads)
+	{
+	}
+
+	// part of the world the view shows, the box around it when the view is rotated
+	static sf::FloatRect viewBounds(const sf::View& view)
+	{
+		const float radians = view.getRotation() * 3.14159265f / 180.f;
+		const float cosine = std::abs(std::cos(radians)), sine = std::abs(std::sin(radians));
+		const float halfWidth = (view.getSize().x * cosine + view.getSize().y * sine) / 2.f;
+		const float halfHeight = (view.getSize().x * sine + view.getSize().y * cosine) / 2.f;
+
+		return sf::FloatRect(view.getCenter().x - halfWidth, view.getCenter().y - halfHeight, halfWidth * 2.f, halfHeight * 2.f);
+	}
+
+	// walls and stairs of a new floor, tileSize is the size of a tile in pixels. Drops every rendered page.
+	void buildStatic(const std::vector<sf::FloatRect>& walls, sf::FloatRect stairs, float tileSize)
+	{
+		_pages.clear();
+		_tileSize = tileSize;
+		_staticQuads = 0;
+		_pageTextures = 0;
+
+		for (const sf::FloatRect& wall : walls)
+			appendStatic(wall, TextureAtlas::Wall);
+		appendStatic(stairs, TextureAtlas::Stairs);
+	}
+
+	// coins and enemies in the visible part of the world, where they are now. Only the ones in view are looked at.
+	void update(const EntityStore& entities, sf::FloatRect visible)
+	{
+		_pickups.clear();
+		_actors.clear();
+
+		entities.findIntersecting(EntityStore::Coin, visible, _visible);
+		for (EntityHandle coin : _visible)
+			appendQuad(_pickups, entities.getBounds(coin), TextureAtlas::Coin, sf::Color::White);
+
+		entities.findIntersecting(EntityStore::Enemy, visible, _visible);
+		for (EntityHandle enemy : _visible)
+			appendQuad(_actors, entities.getBounds(enemy), TextureAtlas::Slime, sf::Color::Red);
+	}
+
+	// the static pages under visible, rendering the ones not cached yet, then the pickups and the actors. Returns the draw calls made.
+	int drawTo(sf::RenderTarget& target, sf::FloatRect visible)
+	{
+		sf::RenderStates states(&_atlas.getTexture());
+		int drawCalls = 2;
+		++_frame;
+
+		forEachVisiblePage(_pages, visible, [&](Page& page, int x, int y) {
+			page.lastShown = _frame;
+			++drawCalls;
+			if (!page.texture && (page.uncached || !render(page, x, y))) {
+				// no render texture available, the quads are drawn as they are
+				target.draw(page.quads, states);
+				return;
+			}
+
+			sf::Sprite sprite(page.texture->getTexture());
+			sprite.setPosition(x * pageSize(), y * pageSize());
+			target.draw(sprite);
+		});
+
+		target.draw(_pickups, states);
+		target.draw(_actors, states);
+		return drawCalls;
+	}
+
+	// what drawTo costs : a draw call per visible page plus the two entity layers
+	int countDrawCalls(sf::FloatRect visible) const
+	{
+		int pages = 0;
+		forEachVisiblePage(_pages, visible, [&](const Page&, int, int) { ++pages; });
+		return pages + 2;
+	}
+
+	int getPageTextureCount() const
+	{
+		return _pageTextures;
+	}
+
+	int getQuadCount(Layer layer) const
+	{
+		if (layer == StaticLayer)
+			return _staticQuads;
+
+		return static_cast<int>((layer == PickupLayer ? _pickups : _actors).getVertexCount() / 4);
+	}
+
+private:
+	struct Page
+	{
+		sf::VertexArray quads; // every tile overlapping the page, the texture crops them to it
+		std::unique_ptr<sf::RenderTexture> texture; // null until the page first shows, or once dropped
+		bool uncached = false; // its texture couldn't be created, it is drawn from the quads without trying again
+		long long lastShown = 0;
+	};
+
+	// pages is _pages, const or not
+	template <typename Pages, typename Visit>
+	void forEachVisiblePage(Pages& pages, sf::FloatRect visible, Visit visit) const
+	{
+		const int left = pageOf(visible.left), right = pageOf(visible.left + visible.width);
+		const int top = pageOf(visible.top), bottom = pageOf(visible.top + visible.height);
+
+		for (int y = top; y <= bottom; ++y)
+			for (int x = left; x <= right; ++x) {
+				auto it = pages.find(key(x, y));
+				if (it != pages.end())
+					visit(it->second, x, y);
+			}
+	}
+
+	// both coordinates as 32 unsigned bits, a negative one is never shifted
+	static unsigned long long key(int x, int y)
+	{
+		return (static_cast<unsigned long long>(static_cast<unsigned int>(x)) << 32) | static_cast<unsigned int>(y);
+	}
+
+	float pageSize() const
+	{
+		return _tileSize * pageTiles;
+	}
+
+	int pageOf(float pixel) const
+	{
+		return static_cast<int>(std::floor(pixel / pageSize()));
+	}
+
+	// page of the far side of a box, a box ending right on a page border doesn't reach the next page
+	int lastPageOf(float pixel) const
+	{
+		return static_cast<int>(std::ceil(pixel / pageSize())) - 1;
+	}
+
+	// the quad goes in every page it overlaps (the stairs are off the grid by half a tile)
+	void appendStatic(sf::FloatRect box, TextureAtlas::Frame frame)
+	{
+		for (int y = pageOf(box.top); y <= lastPageOf(box.top + box.height); ++y)
+			for (int x = pageOf(box.left); x <= lastPageOf(box.left + box.width); ++x) {
+				sf::VertexArray& quads = _pages[key(x, y)].quads;
+				quads.setPrimitiveType(sf::Quads);
+				appendQuad(quads, box, frame, sf::Color::White);
+			}
+		++_staticQuads;
+	}
+
+	// draws the quads of the page into its texture once, false when the texture can't be created (the page is then left uncached)
+	bool render(Page& page, int x, int y)
+	{
+		if (_pageTextures >= maxPageTextures)
+			dropOldestTexture();
+
+		const unsigned int size = static_cast<unsigned int>(std::ceil(pageSize()));
+		std::unique_ptr<sf::RenderTexture> texture(new sf::RenderTexture());
+		if (!texture->create(size, size)) {
+			page.uncached = true;
+			return false;
+		}
+
+		texture->setView(sf::View(sf::FloatRect(x * pageSize(), y * pageSize(), static_cast<float>(size), static_cast<float>(size))));
+		texture->clear(sf::Color::Transparent);
+		texture->draw(page.quads, sf::RenderStates(&_atlas.getTexture()));
+		texture->display();
+
+		page.texture = std::move(texture);
+		++_pageTextures;
+		return true;
+	}
+
+	void dropOldestTexture()
+	{
+		Page* oldest = nullptr;
+		for (auto& entry : _pages)
+			if (entry.second.texture && (oldest == nullptr || entry.second.lastShown < oldest->lastShown))
+				oldest = &entry.second;
+
+		if (oldest != nullptr) {
+			oldest->texture.reset();
+			--_pageTextures;
+		}
+	}
+
+	void appendQuad(sf::VertexArray& layer, sf::FloatRect box, TextureAtlas::Frame frame, sf::Color color)
+	{
+		sf::IntRect rect = _atlas.getRect(frame);
+		float left = static_cast<float>(rect.left), top = static_cast<float>(rect.top);
+		float right = left + rect.width, bottom = top + rect.height;
+
+		layer.append(sf::Vertex(sf::Vector2f(box.left, box.top), color, sf::Vector2f(left, top)));
+		layer.append(sf::Vertex(sf::Vector2f(box.left + box.width, box.top), color, sf::Vector2f(right, top)));
+		layer.append(sf::Vertex(sf::Vector2f(box.left + box.width, box.top + box.height), color, sf::Vector2f(right, bottom)));
+		layer.append(sf::Vertex(sf::Vector2f(box.left, box.top + box.height), color, sf::Vector2f(left, bottom)));
+	}
+
+private:
+	const TextureAtlas& _atlas;
+	float _tileSize; // in pixels
+	std::unordered_map<unsigned long long, Page> _pages; // static layer, by page coordinates
+	int _staticQuads;
+	int _pageTextures; // pages with a texture
+	long long _frame; // drawTo calls, to find the page shown the longest ago
+	sf::VertexArray _pickups;
+	sf::VertexArray _actors;
+	std::vector<EntityHandle> _visible; // entities found by update, kept so a frame allocates nothing
+};
@@ -1,416 +1,71 @@
 ﻿#include <random>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 #include <SFML/Graphics.hpp>
 #include <sstream>
+#include <future>
+#include <memory>
 #include "Player.h"
-#include "Coin.h"
-#include "Ground.h"
-#include "Enemy.h"
 #include "QuadTree.h"
-#include "EmptySpace.h"
-#include "Stairs.h"
-
-
-namespace
-{
-	std::random_device rd;
-	std::mt19937 mt(rd());
-
-	int randomInt(int exclusiveMax)
-	{
-		std::uniform_int_distribution<> dist(0, exclusiveMax - 1);
-		return dist(mt);
-	}
-
-	int randomInt(int min, int max) // inclusive min/max
-	{
-		std::uniform_int_distribution<> dist(0, max - min);
-		return dist(mt) + min;
-	}
-
-	bool randomBool(double probability = 0.5)
-	{
-		std::bernoulli_distribution dist(probability);
-		return dist(mt);
-	}
-}
-
-struct Rect
+#include "Dungeon.h"
+#include "Random.h"
+#include "ChunkedWorld.h"
+#include "Level.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "AssetLoader.h"
+#include "ResourceCache.h"
+#include "TextureAtlas.h"
+#include "TileMapRenderer.h"
+
+int main(int argc, char* argv[])
 {
-	int x, y;
-	int width, height;
-};
-
-class Dungeon
-{
-public:
-	enum Tile
-	{
-		Unused = ' ',
-		Floor = '.',
-		Corridor = ',',
-		Wall = '#',
-		ClosedDoor = '+',
-		OpenDoor = '-',
-		UpStairs = '<',
-		DownStairs = '>',
-		Coin = '*',
-		Enemy = '/'
-	};
-
-	enum Direction
-	{
-		North,
-		South,
-		West,
-		East,
-		DirectionCount
-	};
-
-public:
-	Dungeon(int width, int height)
-		: _width(width)
-		, _height(height)
-		, _tiles(width* height, Unused)
-		, _rooms()
-		, _exits()
-	{
-	}
-
-	void generate(int maxFeatures)
-	{
-		// place the first room in the center
-		if (!makeRoom(_width / 2, _height / 2, static_cast<Direction>(randomInt(4), true)))
-		{
-			std::cout << "Unable to place the first room.\n";
-			return;
-		}
-
-		// we already placed 1 feature (the first room)
-		for (int i = 1; i < maxFeatures; ++i)
-		{
-			if (!createFeature())
-			{
-				std::cout << "Unable to place more features (placed " << i << ").\n";
-				break;
-			}
-		}
-
-		if (!placeObject(UpStairs))
-		{
-			std::cout << "Unable to place up stairs.\n";
-			return;
-		}
-
-		if (!placeObject(DownStairs))
-		{
-			std::cout << "Unable to place down stairs.\n";
-			return;
-		}
-
-		for (char& tile : _tiles)
-		{
-			if (tile == Unused)
-				tile = '.';
-			else if (tile == Floor || tile == Corridor)
-				tile = ' ';
-		}
-	}
-
-	void print()
-	{
-		for (int y = 0; y < _height; ++y)
-		{
-			for (int x = 0; x < _width; ++x)
-				std::cout << getTile(x, y);
-
-			std::cout << std::endl;
-		}
-	}
-
-	std::vector<char> getTiles() {
-		return this->_tiles;
-	}
-
-private:
-	char getTile(int x, int y) const
-	{
-		if (x < 0 || y < 0 || x >= _width || y >= _height)
-			return Unused;
-
-		return _tiles[x + y * _width];
-	}
-
-	void setTile(int x, int y, char tile)
-	{
-		_tiles[x + y * _width] = tile;
-	}
-
-	bool createFeature()
-	{
-		for (int i = 0; i < 1000; ++i)
-		{
-			if (_exits.empty())
-				break;
-
-			// choose a random side of a random room or corridor
-			int r = randomInt(_exits.size());
-			int x = randomInt(_exits[r].x, _exits[r].x + _exits[r].width - 1);
-			int y = randomInt(_exits[r].y, _exits[r].y + _exits[r].height - 1);
-
-			// north, south, west, east
-			for (int j = 0; j < DirectionCount; ++j)
-			{
-				if (createFeature(x, y, static_cast<Direction>(j)))
-				{
-					_exits.erase(_exits.begin() + r);
-					return true;
-				}
-			}
-		}
-
-		return false;
-	}
-
-	bool createFeature(int x, int y, Direction dir)
-	{
-		static const int roomChance = 50; // corridorChance = 100 - roomChance
-
-		int dx = 0;
-		int dy = 0;
-
-		if (dir == North)
-			dy = 1;
-		else if (dir == South)
-			dy = -1;
-		else if (dir == West)
-			dx = 1;
-		else if (dir == East)
-			dx = -1;
-
-		if (getTile(x + dx, y + dy) != Floor && getTile(x + dx, y + dy) != Corridor)
-			return false;
-
-		if (randomInt(100) < roomChance)
-		{
-			if (makeRoom(x, y, dir))
-			{
-				setTile(x, y, ClosedDoor);
-
-				return true;
-			}
-		}
-
-		else
-		{
-			if (makeCorridor(x, y, dir))
-			{
-				if (getTile(x + dx, y + dy) == Floor)
-					setTile(x, y, ClosedDoor);
-				else // don't place a door between corridors
-					setTile(x, y, Corridor);
-
-				return true;
-			}
-		}
-
-		return false;
-	}
-
-	bool makeRoom(int x, int y, Direction dir, bool firstRoom = false)
-	{
-		static const int minRoomSize = 3;
-		static const int maxRoomSize = 6;
-
-		Rect room;
-		room.width = randomInt(minRoomSize, maxRoomSize);
-		room.height = randomInt(minRoomSize, maxRoomSize);
-
-		if (dir == North)
-		{
-			room.x = x - room.width / 2;
-			room.y = y - room.height;
-		}
-
-		else if (dir == South)
-		{
-			room.x = x - room.width / 2;
-			room.y = y + 1;
-		}
-
-		else if (dir == West)
-		{
-			room.x = x - room.width;
-			room.y = y - room.height / 2;
-		}
-
-		else if (dir == East)
-		{
-			room.x = x + 1;
-			room.y = y - room.height / 2;
-		}
-
-		if (placeRect(room, Floor))
-		{
-			_rooms.emplace_back(room);
-
-			if (dir != South || firstRoom) // north side
-				_exits.emplace_back(Rect{ room.x, room.y - 1, room.width, 1 });
-			if (dir != North || firstRoom) // south side
-				_exits.emplace_back(Rect{ room.x, room.y + room.height, room.width, 1 });
-			if (dir != East || firstRoom) // west side
-				_exits.emplace_back(Rect{ room.x - 1, room.y, 1, room.height });
-			if (dir != West || firstRoom) // east side
-				_exits.emplace_back(Rect{ room.x + room.width, room.y, 1, room.height });
-
-			return true;
-		}
-
-		return false;
-	}
-
-	bool makeCorridor(int x, int y, Direction dir)
-	{
-		static const int minCorridorLength = 3;
-		static const int maxCorridorLength = 6;
-
-		Rect corridor;
-		corridor.x = x;
-		corridor.y = y;
-
-		if (randomBool()) // horizontal corridor
-		{
-			corridor.width = randomInt(minCorridorLength, maxCorridorLength);
-			corridor.height = 1;
-
-			if (dir == North)
-			{
-				corridor.y = y - 1;
-
-				if (randomBool()) // west
-					corridor.x = x - corridor.width + 1;
-			}
-
-			else if (dir == South)
-			{
-				corridor.y = y + 1;
-
-				if (randomBool()) // west
-					corridor.x = x - corridor.width + 1;
-			}
-
-			else if (dir == West)
-				corridor.x = x - corridor.width;
-
-			else if (dir == East)
-				corridor.x = x + 1;
+	sf::Clock startupClock;
+
+	// the seed can be given on the command line to replay a level, --infinite streams an endless world instead of one floor,
+	// --save <file> writes the first floor to a level file and --load <file> plays a saved floor first,
+	// --profile <file> writes the time of every zone of every frame on exit, as a trace if the file ends in .json, else as CSV
+	unsigned int seed = Random::randomSeed();
+	bool infiniteMode = false;
+	std::string savePath, loadPath, profilePath;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--infinite") {
+			infiniteMode = true;
 		}
-
-		else // vertical corridor
-		{
-			corridor.width = 1;
-			corridor.height = randomInt(minCorridorLength, maxCorridorLength);
-
-			if (dir == North)
-				corridor.y = y - corridor.height;
-
-			else if (dir == South)
-				corridor.y = y + 1;
-
-			else if (dir == West)
-			{
-				corridor.x = x - 1;
-
-				if (randomBool()) // north
-					corridor.y = y - corridor.height + 1;
-			}
-
-			else if (dir == East)
-			{
-				corridor.x = x + 1;
-
-				if (randomBool()) // north
-					corridor.y = y - corridor.height + 1;
+		else if (arg == "--save" || arg == "--load" || arg == "--profile") {
+			if (i + 1 >= argc) {
+				LOG_ERROR(arg << " needs a file, ignored");
+				continue;
 			}
+			std::string& path = arg == "--save" ? savePath : (arg == "--load" ? loadPath : profilePath);
+			path = argv[++i];
 		}
-
-		if (placeRect(corridor, Corridor))
-		{
-			if (dir != South && corridor.width != 1) // north side
-				_exits.emplace_back(Rect{ corridor.x, corridor.y - 1, corridor.width, 1 });
-			if (dir != North && corridor.width != 1) // south side
-				_exits.emplace_back(Rect{ corridor.x, corridor.y + corridor.height, corridor.width, 1 });
-			if (dir != East && corridor.height != 1) // west side
-				_exits.emplace_back(Rect{ corridor.x - 1, corridor.y, 1, corridor.height });
-			if (dir != West && corridor.height != 1) // east side
-				_exits.emplace_back(Rect{ corridor.x + corridor.width, corridor.y, 1, corridor.height });
-
-			return true;
+		else {
+			// anything else has to be the seed, a bad one is reported and the random seed is kept
+			char* end = nullptr;
+			errno = 0;
+			unsigned long value = std::strtoul(arg.c_str(), &end, 10);
+			if (arg.empty() || !std::isdigit(static_cast<unsigned char>(arg[0])) || *end != '\0' || errno == ERANGE || value > UINT_MAX)
+				LOG_ERROR("Unknown argument " << arg << ", expected a seed, --infinite, --save <file>, --load <file> or --profile <file>");
+			else
+				seed = static_cast<unsigned int>(value);
 		}
-
-		return false;
 	}
-
-	bool placeRect(const Rect& rect, char tile)
-	{
-		if (rect.x < 1 || rect.y < 1 || rect.x + rect.width > _width - 1 || rect.y + rect.height > _height - 1)
-			return false;
-
-		for (int y = rect.y; y < rect.y + rect.height; ++y)
-			for (int x = rect.x; x < rect.x + rect.width; ++x)
-			{
-				if (getTile(x, y) != Unused)
-					return false; // the area already used
-			}
-
-		for (int y = rect.y - 1; y < rect.y + rect.height + 1; ++y)
-			for (int x = rect.x - 1; x < rect.x + rect.width + 1; ++x)
-			{
-				if (x == rect.x - 1 || y == rect.y - 1 || x == rect.x + rect.width || y == rect.y + rect.height)
-					setTile(x, y, Wall);
-				else
-					setTile(x, y, tile);
-			}
-
-		return true;
+	// a saved floor is played as it is : there is nothing to save again, and the endless world has no floor to load
+	if (!loadPath.empty() && infiniteMode) {
+		LOG_ERROR("--load can't be used with --infinite, ignored");
+		loadPath.clear();
 	}
-
-	bool placeObject(char tile)
-	{
-		if (_rooms.empty())
-			return false;
-
-		int r = randomInt(_rooms.size()); // choose a random room
-		int x = randomInt(_rooms[r].x + 1, _rooms[r].x + _rooms[r].width - 2);
-		int y = randomInt(_rooms[r].y + 1, _rooms[r].y + _rooms[r].height - 2);
-
-		if (getTile(x, y) == Floor)
-		{
-			setTile(x, y, tile);
-
-			// place one object in one room (optional)
-			_rooms.erase(_rooms.begin() + r);
-
-			return true;
-		}
-
-		return false;
+	if (!savePath.empty() && (infiniteMode || !loadPath.empty())) {
+		LOG_ERROR("--save only saves a generated floor, it can't be used with " << (infiniteMode ? "--infinite" : "--load") << ", ignored");
+		savePath.clear();
 	}
+	LOG_INFO("Seed: " << seed);
 
-private:
-	int _width, _height;
-	std::vector<char> _tiles;
-	std::vector<Rect> _rooms; // rooms for place stairs or monsters
-	std::vector<Rect> _exits; // 4 sides of rooms or corridors
-};
-
-int main()
-{
-
-	Dungeon d(70, 20);
-	d.generate(15);
-	//d.print();
-	std::vector<char> allTiles = d.getTiles();
 
 	//std::cout << "Press Enter to quit... ";
 	//std::cin.get();
@@ -434,10 +89,8 @@ int main()
 	view.reset(sf::FloatRect(0, 0, screenDimensionX, screenDimensionY));
 	view.setViewport(sf::FloatRect(0, 0, 1.0f, 1.0f));
 
+	// tiles are square, the floors and the chunks only take one size
 	const int globalBlocSizeX = 40;
-	const int globalBlocSizeY = 40;
-	int lineCheck = 0;
-	std::vector<Ground*> collisionTab;
 
 	bool isRotating = false;
 	float rotationStep = 240.f;
@@ -448,56 +101,46 @@ int main()
 	topDirections[2] = sf::Vector2f(0.f, 1.f);
 	topDirections[3] = sf::Vector2f(-1.f, 0.f);
 	int topDirectionIndex = 0;
-	//Empty textyre
-	sf::Texture emptyTexture;
-
-	//Wall texture
-	sf::Texture wallTexture;
-	if (!wallTexture.loadFromFile("res/img/wall.png")) {
-		std::cout << "Load failed" << std::endl;
-
-		system("pause");
-	}
-
-	//Stairs texture
-	sf::Texture stairsTexture;
-	if (!stairsTexture.loadFromFile("res/img/stairs.png")) {
-		std::cout << "Load failed" << std::endl;
-
-		system("pause");
-	}
-	Stairs stairs({ globalBlocSizeX,globalBlocSizeY }, &stairsTexture);
-
-	//Coin texture
-	sf::Texture coinTexture;
-	if (!coinTexture.loadFromFile("res/img/coin.png")) {
-		std::cout << "Load failed" << std::endl;
-
-		system("pause");
+	//Textures and fonts, every file is loaded once for the whole game.
+	//They are decoded on worker threads while the first floor is generated and the menu shows,
+	//the pointers are handed out now and the textures are made from the decoded files in the menu loop.
+	//Walls and stairs have no texture of their own, they are drawn from the atlas, so the floors can be built before it is ready.
+	Resources resources;
+	sf::Texture* playertexture = resources.textures.reserve(TextureAtlas::getPath(TextureAtlas::Chara));
+	sf::Font* minecraft = resources.fonts.reserve("res/fonts/Minecraft.ttf");
+
+	//Every image in one texture, the floor is drawn from it a layer at a time
+	TextureAtlas atlas;
+	sf::Image atlasImages[TextureAtlas::FrameCount];
+
+	AssetLoader loader;
+	std::vector<std::string> imagePaths;
+	for (int i = 0; i < TextureAtlas::FrameCount; i++) {
+		imagePaths.push_back(TextureAtlas::getPath(static_cast<TextureAtlas::Frame>(i)));
 	}
+	loader.start(imagePaths, { "res/fonts/Minecraft.ttf" });
 
-	//Enemy texture
-	sf::Texture enemyTexture;
-	if (!enemyTexture.loadFromFile("res/img/slime.jpg")) {
-		std::cout << "Load failed" << std::endl;
+	// main thread side of the loading : every decoded file becomes a texture or a font, the images also go in the atlas
+	auto useAsset = [&](AssetLoader::Asset& asset) {
+		if (asset.font) {
+			resources.fonts.load(asset.path, [&asset](sf::Font& font) { return asset.loaded && font.loadFromMemory(asset.bytes->data(), asset.bytes->size()); },
+				asset.bytes, asset.bytes->size(), asset.decodeSeconds);
+			return;
+		}
 
-		system("pause");
-	}
+		for (int i = 0; i < TextureAtlas::FrameCount; i++) {
+			if (asset.path == imagePaths[i])
+				atlasImages[i] = asset.image;
+		}
+		if (asset.path == imagePaths[TextureAtlas::Chara])
+			resources.textures.load(asset.path, [&asset](sf::Texture& texture) { return asset.loaded && texture.loadFromImage(asset.image); }, nullptr, 0, asset.decodeSeconds);
+	};
 
 	//Player instance
-	sf::Texture playertexture;
-
-	if (!playertexture.loadFromFile("res/img/chara.png")) {
-		std::cout << "Load failed" << std::endl;
-
-		system("pause");
-	}
-	Player player({ 20,20 }, &playertexture);
+	Player player({ 20,20 }, playertexture);
 	player.setPos({ 50,500 });
 
 	//Game Over object
-	sf::Font minecraft;
-	minecraft.loadFromFile("res/fonts/Minecraft.ttf");
 
 	std::ostringstream ssBigMessage;
 	ssBigMessage << "";
@@ -505,7 +148,7 @@ int main()
 	sf::Text lblBigMessage;
 	lblBigMessage.setCharacterSize(100);
 	lblBigMessage.setPosition({ 50,200 });
-	lblBigMessage.setFont(minecraft);
+	lblBigMessage.setFont(*minecraft);
 	lblBigMessage.setString(ssBigMessage.str());
 
 	//Score object
@@ -517,7 +160,7 @@ int main()
 	sf::Text lblScore;
 	lblScore.setCharacterSize(30);
 	lblScore.setPosition({ 10,10 });
-	lblScore.setFont(minecraft);
+	lblScore.setFont(*minecraft);
 	lblScore.setString(ssScore.str());
 
 	//Life object
@@ -529,114 +172,118 @@ int main()
 	sf::Text lblLife;
 	lblLife.setCharacterSize(30);
 	lblLife.setPosition({ 600,10 });
-	lblLife.setFont(minecraft);
+	lblLife.setFont(*minecraft);
 	lblLife.setString(ssLife.str());
 
 
 	//Handle all items from generated map
-	float LayerX = 0;
-	float LayerY = 0;
-	std::vector<Ground*> wallVector;
-	std::vector<Coin*> coinVector;
-	std::vector<Enemy*> enemyVector;
-	std::vector<EmptySpace*> emptyVector;
-
-	float playerX = 0.f, playerY = 0.f;
-
-	for (int i = 0; i < allTiles.size(); i++) {
-		//Go to a new line
-		if (lineCheck == 70) {
-			lineCheck = 0;
-			LayerY = 0;
-			LayerX = LayerX + 40;
-		}
-		//If Tile = Wall
-		if (allTiles[i] == '#') {
-			Ground* wall = new Ground({ globalBlocSizeX,globalBlocSizeY }, &wallTexture);
-			wallVector.push_back(wall);
-			collisionTab.push_back(wall);
-			wall->setPos({ LayerY, LayerX });
-			std::cout << wall->getX() << " is X" << std::endl;
-			std::cout << wall->getY() << " is Y" << std::endl;
-		}
-		//If Tile = Character
-		if (allTiles[i] == '>') {
-			player.setPos({ LayerY, LayerX });
-			playerX = LayerY;
-			playerY = LayerX;
-		}
-		//If Tile = Stairs
-		if (allTiles[i] == '<') {
-			stairs.setPos({ LayerY, LayerX });
-		}
-		//Generate coin or monster on empty space
-		if (allTiles[i] == ' ') {
-			EmptySpace* emptySpace = new EmptySpace({ globalBlocSizeX, globalBlocSizeY }, &emptyTexture);
-			emptyVector.push_back(emptySpace);
-			emptySpace->setPos({ LayerY, LayerX });
-
-		}
-		else {
-			//Empty for now
-		}
-		lineCheck = lineCheck++;
-
-		LayerY = LayerY + 40;
+	TileMapRenderer tileMap(atlas);
+	const Level* tileMapLevel = nullptr; // floor the static layer of tileMap was built for
+	std::vector<EntityHandle> touchedEntities;
+	std::vector<sf::FloatRect> wallBoxes; // walls overlapping the player, refilled every frame
+	std::unique_ptr<Level> level;
+	if (!loadPath.empty()) {
+		level = Level::load(loadPath, globalBlocSizeX);
+		if (!level)
+			LOG_ERROR("Unable to load " << loadPath << ", a new floor is generated instead");
 	}
-	int emptyBlocNum = 0;
-	int coinChecker = 0;
-	int enemyChecker = 0;
-	int maxEnemyPerLevel = randomInt(5);
-	int maxCoinPerLevel = randomInt(5);
-
-	for (int i = 0; i < emptyVector.size(); i++) {
-		emptyBlocNum = emptyBlocNum + 1;
-	}
-	for (int i = 0; i < emptyVector.size(); i++) {
-		if (coinChecker <= maxCoinPerLevel) {
-			int randomEmpty = randomInt(emptyBlocNum);
-			float EmptyPosX = emptyVector[randomEmpty]->getX();
-			float EmptyPosY = emptyVector[randomEmpty]->getY();
-			coinChecker = coinChecker++;
-
-			Coin* coin = new Coin({ globalBlocSizeX, globalBlocSizeY }, &coinTexture);
-			coinVector.push_back(coin);
-			coin->setPos({ EmptyPosX, EmptyPosY });
-		}
-
-	}
-	for (int i = 0; i < emptyVector.size(); i++) {
-
-		if (enemyChecker <= maxEnemyPerLevel) {
-			std::cout << "i'm in ???" << std::endl;
-			int randomEmpty = randomInt(emptyBlocNum);
-			float EmptyPosX = emptyVector[randomEmpty]->getX();
-			float EmptyPosY = emptyVector[randomEmpty]->getY();
-			enemyChecker = enemyChecker++;
-
-			Enemy* enemy = new Enemy({ globalBlocSizeX, globalBlocSizeY }, &enemyTexture);
-			enemyVector.push_back(enemy);
-			enemy->setPos({ EmptyPosX, EmptyPosY });
-		}
+	if (!level)
+		level.reset(new Level(Level::floorSeed(seed, 1), globalBlocSizeX, infiniteMode));
+	if (!savePath.empty() && !level->save(savePath))
+		LOG_ERROR("Unable to save the floor to " << savePath);
+	float playerX = level->getPlayerStart().x, playerY = level->getPlayerStart().y;
+
+	// the next floor is built on a background thread while the current one is played, so taking the stairs is only a swap
+	const int floorCount = 3;
+	int floorNumber = 1;
+	auto buildLevel = [](unsigned int levelSeed, std::unique_ptr<Level> previous) {
+		// the floor that was just left is freed here rather than on the game thread
+		previous.reset();
+		return std::unique_ptr<Level>(new Level(levelSeed, globalBlocSizeX));
+	};
+	std::future<std::unique_ptr<Level>> nextLevel;
+	if (!infiniteMode) {
+		nextLevel = std::async(std::launch::async, buildLevel, Level::floorSeed(seed, floorNumber + 1), std::unique_ptr<Level>());
 	}
 
-	//create quadTree to check collisions
-	QuadTree quadTree(sf::FloatRect(0.f, 0.f, 70 * 40, 20 * 40), 0);
-
-	// Add objects in the quadTree
-	for (int i = 0; i < wallVector.size(); i++) {
-		quadTree.insert(wallVector[i]);
+	// endless world, chunks are loaded and evicted around the player
+	std::unique_ptr<ChunkedWorld> world;
+	if (infiniteMode) {
+		world.reset(new ChunkedWorld(seed, globalBlocSizeX));
+		playerX = world->getStartPosition().x;
+		playerY = world->getStartPosition().y;
 	}
 
 	bool isPlaying = true, first = false, mainMenu = true;
+
+	//Name of the game
+	sf::Text menuMessage;
+	menuMessage.setString("Dungeon Crawler");
+	menuMessage.setFont(*minecraft);
+	menuMessage.setCharacterSize(70);
+	sf::FloatRect menuMessageRect = menuMessage.getLocalBounds();
+	menuMessage.setOrigin(menuMessageRect.left + menuMessageRect.width / 2.0f, menuMessageRect.top + menuMessageRect.height / 2.0f);
+
+	//Instruction to start the game
+	sf::Text menuStartMessage;
+	menuStartMessage.setString("Press enter to start !");
+	menuStartMessage.setFont(*minecraft);
+	menuStartMessage.setCharacterSize(40);
+	sf::FloatRect menuStartMessageRect = menuStartMessage.getLocalBounds();
+	menuStartMessage.setOrigin(menuStartMessageRect.left + menuStartMessageRect.width / 2.0f, menuStartMessageRect.top + menuStartMessageRect.height / 2.0f);
 	float posX = 0.f, posY = 0.f;
 
+	//Loading bar of the main menu
+	sf::RectangleShape loadingBar;
+	loadingBar.setFillColor(sf::Color::White);
+	bool firstFrame = true;
+
+#if PROFILER_ENABLED
+	// F3 shows where the frame time goes
+	bool showProfiler = false;
+	sf::Text profilerText;
+	profilerText.setFont(*minecraft);
+	profilerText.setCharacterSize(16);
+	profilerText.setPosition({ 10,50 });
+	if (!profilePath.empty())
+		Profiler::instance().record();
+#endif
+
 	while (window.isOpen())
 	{
+		PROFILE_FRAME();
 		deltaTime = clock.restart().asSeconds();
+
+		// the assets decoded since the last frame, once they are all there the menu texts can be measured
+		if (!loader.isDone()) {
+			PROFILE_ZONE("assets");
+			loader.poll(useAsset);
+
+			if (loader.isDone()) {
+				if (!atlas.pack(atlasImages) || !resources.textures.allLoaded() || !resources.fonts.allLoaded()) {
+					LOG_ERROR("Load failed");
+
+					system("pause");
+				}
+
+				player.setTexture(playertexture);
+				menuMessageRect = menuMessage.getLocalBounds();
+				menuMessage.setOrigin(menuMessageRect.left + menuMessageRect.width / 2.0f, menuMessageRect.top + menuMessageRect.height / 2.0f);
+				menuStartMessageRect = menuStartMessage.getLocalBounds();
+				menuStartMessage.setOrigin(menuStartMessageRect.left + menuStartMessageRect.width / 2.0f, menuStartMessageRect.top + menuStartMessageRect.height / 2.0f);
+
+				std::ostringstream report;
+				resources.report(report);
+				LOG_INFO("Assets loaded after " << startupClock.getElapsedTime().asMilliseconds() << " ms\n" << report.str());
+			}
+		}
 		//Enemy logic
-		for (int i = 0; i < enemyVector.size(); i++) {
-			if (player.isCollidingWithEnemy(enemyVector[i])) {
+		{
+			PROFILE_ZONE("entities");
+			PROFILE_COUNT("spatial queries", 2);
+			EntityStore& entities = level->getEntities();
+			entities.findIntersecting(EntityStore::Enemy, player.getGlobalBounds(), touchedEntities);
+			for (EntityHandle enemy : touchedEntities) {
 				score = score + 10;
 				life = life - 1;
 				ssScore.str("");
@@ -645,14 +292,13 @@ int main()
 				ssLife.str("");
 				ssLife << "HP:" << life;
 				lblLife.setString(ssLife.str());
-				enemyVector[i]->setPos({ 999999,999999 });
+				entities.destroy(enemy);
 			}
-		}
 
-		//Coin logic
-		for (int i = 0; i < coinVector.size(); i++) {
-			if (player.isCollidingWithCoin(coinVector[i])) {
-				coinVector[i]->setPos({ 999999,999999 });
+			//Coin logic
+			entities.findIntersecting(EntityStore::Coin, player.getGlobalBounds(), touchedEntities);
+			for (EntityHandle coin : touchedEntities) {
+				entities.destroy(coin);
 				score++;
 				ssScore.str("");
 				ssScore << "Score: " << score;
@@ -681,25 +327,9 @@ int main()
 
 			view.setCenter(screenPosition);
 
-			//Name of the game
-			sf::Text message;
-			message.setString("Dungeon Crawler");
-			sf::Font font;
-			font.loadFromFile("res/fonts/minecraft.ttf");
-			message.setFont(font);
-			message.setCharacterSize(70);
-			sf::FloatRect messageRect = message.getLocalBounds();
-			message.setOrigin(messageRect.left + messageRect.width / 2.0f, messageRect.top + messageRect.height / 2.0f);
-			message.setPosition(sf::Vector2f(screenPosition.x, screenPosition.y - 100.f));
-
-			//Instruction to start the game
-			sf::Text scoreMessage;
-			scoreMessage.setString("Press enter to start !");
-			scoreMessage.setFont(font);
-			scoreMessage.setCharacterSize(40);
-			sf::FloatRect scoreMessageRect = scoreMessage.getLocalBounds();
-			scoreMessage.setOrigin(scoreMessageRect.left + scoreMessageRect.width / 2.0f, scoreMessageRect.top + scoreMessageRect.height / 2.0f);
-			scoreMessage.setPosition(sf::Vector2f(screenPosition.x, screenPosition.y + 60.f));
+			// the texts are built once before the loop, only their place follows the screen
+			menuMessage.setPosition(sf::Vector2f(screenPosition.x, screenPosition.y - 100.f));
+			menuStartMessage.setPosition(sf::Vector2f(screenPosition.x, screenPosition.y + 60.f));
 
 			// animation of the player in the main menu
 			posX += 1.f;
@@ -717,16 +347,29 @@ int main()
 			}
 			player.setPos({ posX, posY });
 
-			window.draw(message);
-			window.draw(scoreMessage);
-			player.drawTo(window);
+			if (loader.isDone()) {
+				window.draw(menuMessage);
+				window.draw(menuStartMessage);
+				player.drawTo(window);
+			}
+			else {
+				// nothing to write with yet, a bar fills up as the files come in
+				loadingBar.setSize(sf::Vector2f(300.f * loader.getDoneCount() / loader.getTotalCount(), 10.f));
+				loadingBar.setPosition(sf::Vector2f(screenPosition.x - 150.f, screenPosition.y));
+				window.draw(loadingBar);
+			}
 
 			window.setView(window.getDefaultView());
 
 			window.display();
 
-			// launch the game
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Enter)) {
+			if (firstFrame) {
+				LOG_INFO("First frame after " << startupClock.getElapsedTime().asMilliseconds() << " ms");
+				firstFrame = false;
+			}
+
+			// launch the game once everything is loaded
+			if (loader.isDone() && sf::Keyboard::isKeyPressed(sf::Keyboard::Enter)) {
 				player.setPos({ playerX, playerY });
 				mainMenu = false;
 			}
@@ -772,24 +415,53 @@ int main()
 					}
 				}
 				else {
+					PROFILE_ZONE("update");
 					// We move only if the game isn't rotating
 					player.move((moveSpeed * deltaTime) * topDirections[topDirectionIndex]);
 
-					if (player.isCollidingWithStairs(stairs)) {
-						isPlaying = false;
+					if (infiniteMode) {
+						world->update({ (float)player.getX(), (float)player.getY() });
 					}
 
-					std::vector<Ground*> groundVector = quadTree.getObjects(sf::FloatRect(player.getX(), player.getY(), player.getGlobalBounds().height, player.getGlobalBounds().width));
+					if (player.isCollidingWithStairs(level->getStairs())) {
+						if (floorNumber < floorCount) {
+							// waits only if the next floor isn't ready yet, the old one is freed by the next build
+							std::unique_ptr<Level> previous = std::move(level);
+							level = nextLevel.get();
+							++floorNumber;
+							if (floorNumber < floorCount) {
+								nextLevel = std::async(std::launch::async, buildLevel, Level::floorSeed(seed, floorNumber + 1), std::move(previous));
+							}
+							player.setPos(level->getPlayerStart());
+						}
+						else {
+							isPlaying = false;
+						}
+					}
 
-					// check collisions with ground
-					for (Ground* ground : groundVector) {
-						if (ground > 0) {
-							std::cout << "possible collisions ! " << player.isCollidingWithGround(ground) << std::endl;
-							if (player.isCollidingWithGround(ground)) {
+					{
+						PROFILE_ZONE("collision");
+						// the query only gives the walls the range overlaps, so it is the player's own box
+						sf::FloatRect playerRange = player.getGlobalBounds();
+						if (infiniteMode)
+							world->getWalls(playerRange, wallBoxes);
+						else
+							level->getQuadTree().getObjects(playerRange, wallBoxes);
+						PROFILE_COUNT("spatial queries", 1);
+						PROFILE_COUNT("collision candidates", wallBoxes.size());
+
+						// check collisions with the walls
+						for (const sf::FloatRect& wall : wallBoxes) {
+							LOG_TRACE("possible collision with the wall at " << wall.left << ", " << wall.top);
+							if (player.isCollidingWithWall(wall)) {
 								player.move(-((moveSpeed * deltaTime) * topDirections[topDirectionIndex]));
 							}
 						}
 					}
+
+					// enemies chase the player along the flow field of the floor
+					PROFILE_ZONE("enemies");
+					level->moveEnemies({ (float)player.getX(), (float)player.getY() }, deltaTime);
 				}
 
 
@@ -804,8 +476,13 @@ int main()
 							spaceReleased = true;
 						}
 					}
+#if PROFILER_ENABLED
+					if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+						showProfiler = !showProfiler;
+#endif
 				}
 
+				PROFILE_ZONE("render");
 				window.clear();
 
 				window.draw(lblScore);
@@ -816,12 +493,12 @@ int main()
 
 
 				//Screen Position follow player
-				if (player.getX() + 10 > screenDimensionX / 2)
+				if (infiniteMode || player.getX() + 10 > screenDimensionX / 2)
 					screenPosition.x = player.getX() + 10;
 				else
 					screenPosition.x = screenDimensionX / 2;
 
-				if (player.getY() + 10 > screenDimensionY / 2)
+				if (infiniteMode || player.getY() + 10 > screenDimensionY / 2)
 					screenPosition.y = player.getY() + 10;
 				else
 					screenPosition.y = screenDimensionY / 2;
@@ -830,23 +507,34 @@ int main()
 
 				//Player Tile
 				player.drawTo(window);
-				//Stairs Tile
-				stairs.drawTo(window);
-				//Block Tile
-				for (int i = 0; i < wallVector.size(); i++) {
-					wallVector[i]->drawTo(window);
+				//Stairs, Block, Coin and Enemy Tiles, only what the view shows
+				if (tileMapLevel != level.get()) {
+					tileMap.buildStatic(level->getWalls(), level->getStairs(), globalBlocSizeX);
+					tileMapLevel = level.get();
 				}
-				for (int i = 0; i < coinVector.size(); i++) {
-					coinVector[i]->drawTo(window);
+				sf::FloatRect visible = TileMapRenderer::viewBounds(window.getView());
+				{
+					PROFILE_ZONE("culling");
+					tileMap.update(level->getEntities(), visible);
 				}
-				for (int i = 0; i < enemyVector.size(); i++) {
-					enemyVector[i]->drawTo(window);
+				int drawCalls = tileMap.drawTo(window, visible);
+				if (infiniteMode) {
+					drawCalls += world->drawTo(window, atlas, visible);
 				}
+				PROFILE_COUNT("draw calls", drawCalls);
 				//Quadtree
 				//quadTree.Draw(window);
 
 				window.setView(window.getDefaultView());
 
+#if PROFILER_ENABLED
+				if (showProfiler) {
+					profilerText.setString(Profiler::instance().getSummary());
+					window.draw(profilerText);
+				}
+#endif
+
+				PROFILE_ZONE("display");
 				window.display();
 			}
 			else {
@@ -897,9 +585,7 @@ int main()
 					//Victory Message
 					sf::Text message;
 					message.setString("VICTORY !");
-					sf::Font font;
-					font.loadFromFile("res/fonts/minecraft.ttf");
-					message.setFont(font);
+					message.setFont(*minecraft);
 					message.setCharacterSize(100);
 					sf::FloatRect messageRect = message.getLocalBounds();
 					message.setOrigin(messageRect.left + messageRect.width / 2.0f, messageRect.top + messageRect.height / 2.0f);
@@ -908,7 +594,7 @@ int main()
 					//Score message
 					sf::Text scoreMessage;
 					scoreMessage.setString(ssScore.str());
-					scoreMessage.setFont(font);
+					scoreMessage.setFont(*minecraft);
 					scoreMessage.setCharacterSize(40);
 					sf::FloatRect scoreMessageRect = scoreMessage.getLocalBounds();
 					scoreMessage.setOrigin(scoreMessageRect.left + scoreMessageRect.width / 2.0f, scoreMessageRect.top + scoreMessageRect.height / 2.0f);
@@ -930,6 +616,13 @@ int main()
 		}
 	}
 
+#if PROFILER_ENABLED
+	if (!profilePath.empty()) {
+		bool trace = profilePath.size() >= 5 && profilePath.compare(profilePath.size() - 5, 5, ".json") == 0;
+		if (!(trace ? Profiler::instance().writeTrace(profilePath) : Profiler::instance().writeCsv(profilePath)))
+			LOG_ERROR("Unable to write profile " << profilePath);
+	}
+#endif
 
 	return 0;
 }